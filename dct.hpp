@@ -1,173 +1,590 @@
 #pragma once
 #include <opencv2/core/core.hpp>
+#include "helpers.hpp"
+#include "dct_kernel.hpp"
+#include "parallel.hpp"
+#include "permutation.hpp"
+#include "tlv.hpp"
 
 /*!
- * Uses discrete cosine transformation to hide data in the coefficients of a channel of an image.
+ * Visits the blocks row by row, the default bit layout.
+ */
+#define DCT_ORDER_ROWS    0
+
+/*!
+ * Visits the blocks column by column, the bit layout of earlier versions.
+ */
+#define DCT_ORDER_COLUMNS 1
+
+/*!
+ * Copies a channel of an 8x8 region of an interleaved image into a floating-point workspace.
  *
- * \param img Input image.
- * \param text Text to hide.
+ * \param img Input image with samples of type `T`.
+ * \param px Horizontal offset of the block.
+ * \param py Vertical offset of the block.
+ * \param channel Channel to copy.
+ * \param block Row-major workspace of 64 floats.
+ */
+template<typename T>
+inline void dct_load_block(const cv::Mat& img, int px, int py, int channel, float* block)
+{
+	auto cn = img.channels();
+
+	for (int y = 0; y < Dct<8>::size; y++)
+	{
+		auto row = img.ptr<T>(py + y) + px * cn + channel;
+
+		for (int x = 0; x < Dct<8>::size; x++)
+		{
+			block[y * Dct<8>::size + x] = float(row[x * cn]);
+		}
+	}
+}
+
+/*!
+ * Writes a floating-point workspace back into a channel of an 8x8 region of an interleaved image.
+ *
+ * \param img Output image with samples of type `T`.
+ * \param px Horizontal offset of the block.
+ * \param py Vertical offset of the block.
+ * \param channel Channel to write.
+ * \param block Row-major workspace of 64 floats.
+ */
+template<typename T>
+inline void dct_store_block(cv::Mat& img, int px, int py, int channel, const float* block)
+{
+	auto cn = img.channels();
+
+	for (int y = 0; y < Dct<8>::size; y++)
+	{
+		auto row = img.ptr<T>(py + y) + px * cn + channel;
+
+		for (int x = 0; x < Dct<8>::size; x++)
+		{
+			row[x * cn] = cv::saturate_cast<T>(block[y * Dct<8>::size + x]);
+		}
+	}
+}
+
+/*!
+ * Determines the sequential index of a block within the grid.
+ *
+ * \param x Horizontal position of the block.
+ * \param y Vertical position of the block.
+ * \param blocks_x Number of blocks in a row.
+ * \param blocks_y Number of blocks in a column.
+ * \param order Traversal order, see DCT_ORDER_* constants.
+ *
+ * \return Sequential index of the block.
+ */
+inline int64_t dct_block_index(int x, int y, int blocks_x, int blocks_y, int order)
+{
+	if (order == DCT_ORDER_COLUMNS)
+	{
+		return int64_t(x) * blocks_y + y;
+	}
+
+	return int64_t(y) * blocks_x + x;
+}
+
+/*!
+ * Determines the position of a block within the grid from its sequential index.
+ *
+ * \param index Sequential index of the block, see `dct_block_index`.
+ * \param blocks_x Number of blocks in a row.
+ * \param blocks_y Number of blocks in a column.
+ * \param order Traversal order, see DCT_ORDER_* constants.
+ * \param x Horizontal position of the block.
+ * \param y Vertical position of the block.
+ */
+inline void dct_block_position(int64_t index, int blocks_x, int blocks_y, int order, int& x, int& y)
+{
+	if (order == DCT_ORDER_COLUMNS)
+	{
+		x = int(index / blocks_y);
+		y = int(index % blocks_y);
+		return;
+	}
+
+	x = int(index % blocks_x);
+	y = int(index / blocks_x);
+}
+
+/*!
+ * Determines which bit of the payload is stored in the specified block.
+ *
+ * \param k Sequential index of the block.
+ * \param size Number of bits in the payload.
  * \param mode Storage mode, see STORE_* constants.
- * \param channel Channel to manipulate.
+ *
+ * \return Index of the bit, a value of at least `size` for padding zeros,
+ *         or -1 if the block is to be left untouched.
+ */
+inline int64_t dct_block_bit(int64_t k, int64_t size, int mode)
+{
+	if (k < size)
+	{
+		return k;
+	}
+
+	switch (mode)
+	{
+	case STORE_ONCE:   return -1;
+	case STORE_REPEAT: return size > 0 ? k % size : size;
+	default:           return k;
+	}
+}
+
+/*!
+ * Maximum number of coefficient pairs, and therefore bits, per block.
+ */
+#define DCT_MAX_PAIRS 8
+
+/*!
+ * Determines whether a number of coefficient pairs per block is supported.
+ *
+ * \param pairs Number of bits hidden per block.
+ *
+ * \return Value indicating whether the number is between 1 and DCT_MAX_PAIRS.
+ */
+inline bool dct_pairs_supported(int pairs)
+{
+	return pairs >= 1 && pairs <= DCT_MAX_PAIRS;
+}
+
+/*!
+ * Returns the position of a coefficient pair used for hiding a bit within a block.
+ * The first pair is (6,7)/(5,1), the rest are mid-frequency coefficients
+ * mirrored around the diagonal.
+ *
+ * \param index Index of the pair, less than DCT_MAX_PAIRS.
+ *
+ * \return Row and column of the first, then row and column of the second coefficient.
+ */
+inline const int* dct_pair(int index)
+{
+	static const int pairs[DCT_MAX_PAIRS][4] =
+	{
+		{ 6, 7, 5, 1 },
+		{ 4, 3, 3, 4 },
+		{ 2, 5, 5, 2 },
+		{ 1, 6, 6, 1 },
+		{ 2, 4, 4, 2 },
+		{ 3, 5, 5, 3 },
+		{ 1, 4, 4, 1 },
+		{ 0, 5, 5, 0 }
+	};
+
+	return pairs[index];
+}
+
+/*!
+ * Orders a pair of coefficients according to the bit to be hidden,
+ * the first one being greater for 1, and moves them apart by the intensity.
+ *
+ * \param a First coefficient.
+ * \param b Second coefficient.
+ * \param val Bit to hide.
  * \param intensity Persistence of the hidden data.
+ */
+inline void dct_order_pair(float& a, float& b, int val, int intensity)
+{
+	using namespace std;
+
+	if (val == 0)
+	{
+		if (a > b)
+		{
+			swap(a, b);
+		}
+	}
+	else
+	{
+		if (a < b)
+		{
+			swap(a, b);
+		}
+	}
+
+	if (a > b)
+	{
+		auto d = (intensity - (a - b)) / 2;
+		     a = a + d;
+		     b = b - d;
+	}
+	else
+	{
+		auto d = (intensity - (b - a)) / 2;
+		     a = a - d;
+		     b = b + d;
+	}
+}
+
+/*!
+ * Hides bits in the coefficient pairs of a block.
  *
- * \return Altered image with hidden data.
+ * With a single pair, only two coefficients change, so instead of a forward
+ * and an inverse transform, their basis images are added to the block scaled
+ * by the change of the coefficients. With multiple pairs, a single forward
+ * and inverse transform carries all of the bits.
+ *
+ * \param block Row-major 8x8 spatial block to manipulate in-place.
+ * \param vals Bits to hide per pair, negative values leave the pair untouched.
+ * \param pairs Number of coefficient pairs, see `dct_pair`.
+ * \param intensity Persistence of the hidden data.
  */
-inline cv::Mat encode_dct(const cv::Mat& img, const std::string& text, int mode = STORE_FULL, int channel = 0, int intensity = 30)
+inline void dct_embed_block(float* block, const int* vals, int pairs, int intensity)
+{
+	const auto n = Dct<8>::size;
+
+	if (pairs == 1)
+	{
+		if (vals[0] < 0)
+		{
+			return;
+		}
+
+		auto ba = Dct<8>::basis(6, 7);
+		auto bb = Dct<8>::basis(5, 1);
+
+		auto a0 = Dct<8>::project(block, ba);
+		auto b0 = Dct<8>::project(block, bb);
+
+		auto a = a0;
+		auto b = b0;
+
+		dct_order_pair(a, b, vals[0], intensity);
+
+		auto da = a - a0;
+		auto db = b - b0;
+
+		for (int i = 0; i < n * n; i++)
+		{
+			block[i] += da * ba[i] + db * bb[i];
+		}
+
+		return;
+	}
+
+	float coeffs[n * n];
+
+	Dct<8>::forward(block, coeffs);
+
+	for (int j = 0; j < pairs; j++)
+	{
+		if (vals[j] < 0)
+		{
+			continue;
+		}
+
+		auto pair = dct_pair(j);
+
+		dct_order_pair(coeffs[pair[0] * n + pair[1]], coeffs[pair[2] * n + pair[3]], vals[j], intensity);
+	}
+
+	Dct<8>::inverse(coeffs, block);
+}
+
+/*!
+ * Recovers the bits hidden in the coefficient pairs of a block.
+ *
+ * \param block Row-major 8x8 spatial block.
+ * \param vals Destination of the hidden bits per pair.
+ * \param pairs Number of coefficient pairs, see `dct_pair`.
+ */
+inline void dct_extract_block(const float* block, int* vals, int pairs)
+{
+	const auto n = Dct<8>::size;
+
+	if (pairs == 1)
+	{
+		vals[0] = Dct<8>::project(block, Dct<8>::basis(6, 7)) > Dct<8>::project(block, Dct<8>::basis(5, 1)) ? 1 : 0;
+		return;
+	}
+
+	float coeffs[n * n];
+
+	Dct<8>::forward(block, coeffs);
+
+	for (int j = 0; j < pairs; j++)
+	{
+		auto pair = dct_pair(j);
+
+		vals[j] = coeffs[pair[0] * n + pair[1]] > coeffs[pair[2] * n + pair[3]] ? 1 : 0;
+	}
+}
+
+/*!
+ * Hides data in the coefficients of the specified channels of an interleaved image in-place.
+ * Each 8x8 block of a channel is copied into a small workspace, altered, and
+ * written back with saturation, so no full-image copies are made.
+ * Rows of blocks are processed in parallel, see `parallel_stripes`.
+ *
+ * \param img Image with samples of type `T` to manipulate in-place.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param channels Channels to manipulate.
+ * \param intensity Persistence of the hidden data.
+ * \param order Traversal order of the blocks, see DCT_ORDER_* constants.
+ * \param pairs Number of bits to hide per block, at most DCT_MAX_PAIRS.
+ * \param key Key of the pseudo-random order applied on top of the traversal order, or an empty string to keep it.
+ */
+template<typename T>
+inline void encode_dct_channels(cv::Mat& img, const std::string& text, int mode, const std::vector<int>& channels, int intensity, int order, int pairs, const std::string& key = "")
 {
 	using namespace cv;
 	using namespace std;
 
-	auto block_width  = 8;
-	auto block_height = 8;
+	if (!dct_pairs_supported(pairs))
+	{
+		return;
+	}
+
+	const auto block_width  = Dct<8>::size;
+	const auto block_height = Dct<8>::size;
 	auto grid_width   = img.cols / block_width;
 	auto grid_height  = img.rows / block_height;
 
-	auto i = 0;
-	auto size = text.length() * 8;
+	auto size = int64_t(text.length()) * 8;
 
-	Mat imgfp;
-	img.convertTo(imgfp, CV_32F);
+	Permutation permutation(uint64_t(max(grid_width - 1, 0)) * max(grid_height - 1, 0), key);
 
-	vector<Mat> planes;
-	split(imgfp, planes);
-
-	for (int x = 1; x < grid_width; x++)
+	parallel_stripes(grid_height - 1, [&](int y)
 	{
-		for (int y = 1; y < grid_height; y++)
+		float block[Dct<8>::size * Dct<8>::size];
+		int vals[DCT_MAX_PAIRS];
+
+		for (int x = 0; x < grid_width - 1; x++)
 		{
-			auto px = (x - 1) * block_width;
-			auto py = (y - 1) * block_height;
+			auto k = int64_t(permutation.inverse(dct_block_index(x, y, grid_width - 1, grid_height - 1, order)));
+			auto touched = false;
 
-			Mat block(planes[channel], Rect(px, py, block_width, block_height));
-			Mat trans(Size(block_width, block_height), block.type());
+			for (int j = 0; j < pairs; j++)
+			{
+				auto i = dct_block_bit(k * pairs + j, size, mode);
 
-			dct(block, trans);
+				vals[j] = -1;
 
-			auto a = trans.at<float>(6, 7);
-			auto b = trans.at<float>(5, 1);
-			
-			if (i >= size)
-			{
-				if (mode == STORE_ONCE)
+				if (i < 0)
 				{
-					break;
+					continue;
 				}
-				else if (mode == STORE_REPEAT)
+
+				vals[j] = 0;
+				if (i < size)
 				{
-					i = 0;
+					vals[j] = (text[i / 8] & 1 << i % 8) >> i % 8;
 				}
-			}
 
-			auto val = 0;
-			if (i < size)
-			{
-				val = (text[i / 8] & 1 << i % 8) >> i % 8;
-				i++;
+				touched = true;
 			}
 
-			if (val == 0)
-			{
-				if (a > b)
-				{
-					swap(a, b);
-				}
-			}
-			else
+			if (!touched)
 			{
-				if (a < b)
-				{
-					swap(a, b);
-				}
+				continue;
 			}
 
-			if (a > b)
-			{
-				auto d = (intensity - (a - b)) / 2;
-				     a = a + d;
-				     b = b - d;
-			}
-			else
+			auto px = x * block_width;
+			auto py = y * block_height;
+
+			for (auto channel : channels)
 			{
-				auto d = (intensity - (b - a)) / 2;
-				     a = a - d;
-				     b = b + d;
+				dct_load_block<T>(img, px, py, channel, block);
+				dct_embed_block(block, vals, pairs, intensity);
+				dct_store_block<T>(img, px, py, channel, block);
 			}
+		}
+	});
+}
 
-			trans.at<float>(6, 7) = a;
-			trans.at<float>(5, 1) = b;
-
-			Mat stego(Size(block_width, block_height), block.type());
+/*!
+ * Uses discrete cosine transformation to hide data in the coefficients of multiple channels of an image.
+ * All channels are processed in a single pass over the image.
+ *
+ * \param img Input image.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param channels Channels to manipulate.
+ * \param intensity Persistence of the hidden data.
+ * \param order Traversal order of the blocks, see DCT_ORDER_* constants.
+ * \param pairs Number of bits to hide per block, at most DCT_MAX_PAIRS.
+ * \param key Key of the pseudo-random order in which the blocks are visited, or an empty string to keep the traversal order.
+ *
+ * \return Altered image with hidden data, or an empty image if the number of pairs is not supported.
+ */
+inline cv::Mat encode_dct(const cv::Mat& img, const std::string& text, int mode, const std::vector<int>& channels, int intensity = 30, int order = DCT_ORDER_ROWS, int pairs = 1, const std::string& key = "")
+{
+	using namespace cv;
+	using namespace std;
 
-			idct(trans, stego);
+	Mat stego;
 
-			stego.copyTo(planes[channel](Rect(px, py, block_width, block_height)));
-		}
-
-		if (i >= size && mode == STORE_ONCE)
-		{
-			break;
-		}
+	if (!dct_pairs_supported(pairs))
+	{
+		return stego;
 	}
 
-	Mat mergedfp;
-	merge(planes, mergedfp);
+	if (img.depth() == CV_8U)
+	{
+		img.copyTo(stego);
+		encode_dct_channels<uchar>(stego, text, mode, channels, intensity, order, pairs, key);
+	}
+	else
+	{
+		img.convertTo(stego, CV_32F);
+		encode_dct_channels<float>(stego, text, mode, channels, intensity, order, pairs, key);
+		stego.convertTo(stego, CV_8U);
+	}
 
-	Mat merged;
-	mergedfp.convertTo(merged, CV_8U);
+	return stego;
+}
 
-	return merged;
+/*!
+ * Uses discrete cosine transformation to hide data in the coefficients of a channel of an image.
+ *
+ * \param img Input image.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param channel Channel to manipulate.
+ * \param intensity Persistence of the hidden data.
+ * \param order Traversal order of the blocks, see DCT_ORDER_* constants.
+ * \param pairs Number of bits to hide per block, at most DCT_MAX_PAIRS.
+ * \param key Key of the pseudo-random order in which the blocks are visited, or an empty string to keep the traversal order.
+ *
+ * \return Altered image with hidden data, or an empty image if the number of pairs is not supported.
+ */
+inline cv::Mat encode_dct(const cv::Mat& img, const std::string& text, int mode = STORE_FULL, int channel = 0, int intensity = 30, int order = DCT_ORDER_ROWS, int pairs = 1, const std::string& key = "")
+{
+	return encode_dct(img, text, mode, std::vector<int> { channel }, intensity, order, pairs, key);
 }
 
 /*!
- * Uses discrete cosine transformation to recover data hidden in the coefficients of an image.
+ * Uses discrete cosine transformation to recover a range of the data hidden in the coefficients of an image.
+ * Only the blocks carrying the requested bytes are transformed.
  *
  * \param img Input image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
  * \param channel Channel to manipulate.
+ * \param order Traversal order of the blocks, see DCT_ORDER_* constants.
+ * \param pairs Number of bits hidden per block, at most DCT_MAX_PAIRS.
+ * \param key Key of the order in which the blocks were visited, or an empty string for the traversal order.
  *
- * \return Hidden data extracted form image.
+ * \return Hidden data extracted form image, shorter than requested if the image is too small,
+ *         or an empty string if the number of pairs is not supported.
  */
-inline std::string decode_dct(const cv::Mat& img, int channel = 0)
+inline std::string decode_dct_range(const cv::Mat& img, int64_t offset, int64_t length, int channel = 0, int order = DCT_ORDER_ROWS, int pairs = 1, const std::string& key = "")
 {
 	using namespace cv;
 	using namespace std;
 
-	auto block_width  = 8;
-	auto block_height = 8;
+	if (!dct_pairs_supported(pairs))
+	{
+		return string();
+	}
+
+	const auto block_width  = Dct<8>::size;
+	const auto block_height = Dct<8>::size;
 	auto grid_width   = img.cols / block_width;
 	auto grid_height  = img.rows / block_height;
+	auto capacity     = int64_t(grid_width) * grid_height * pairs / 8;
+
+	string bits(size_t(max(int64_t(0), min(length, capacity - offset))), 0);
+
+	if (grid_width < 2 || grid_height < 2 || bits.empty())
+	{
+		return bits;
+	}
+
+	Mat src = img;
+
+	if (src.depth() != CV_8U)
+	{
+		img.convertTo(src, CV_32F);
+	}
 
-	auto i = 0;
-	string bits(grid_width * grid_height / 8, 0);
+	auto first  = offset * 8;
+	auto last   = first + int64_t(bits.size()) * 8;
+	auto blocks = int64_t(grid_width - 1) * (grid_height - 1);
+	auto begin  = first / pairs;
+	auto end    = min((last + pairs - 1) / pairs, blocks);
+	auto stripe = int64_t(grid_width - 1);
 
-	Mat imgfp;
-	img.convertTo(imgfp, CV_32F);
+	Permutation permutation(uint64_t(blocks), key);
 
-	vector<Mat> planes;
-	split(imgfp, planes);
+	vector<uchar> vals(size_t(max(int64_t(0), end - begin)) * pairs);
 
-	for (int x = 1; x < grid_width; x++)
+	parallel_stripes(int((end - begin + stripe - 1) / stripe), [&](int s)
 	{
-		for (int y = 1; y < grid_height; y++)
+		float block[Dct<8>::size * Dct<8>::size];
+		int extracted[DCT_MAX_PAIRS];
+
+		for (auto k = begin + s * stripe; k < min(begin + (s + 1) * stripe, end); k++)
 		{
-			auto px = (x - 1) * block_width;
-			auto py = (y - 1) * block_height;
+			int x, y;
+			dct_block_position(int64_t(permutation(uint64_t(k))), grid_width - 1, grid_height - 1, order, x, y);
 
-			Mat block(planes[channel], Rect(px, py, block_width, block_height));
-			Mat trans(Size(block_width, block_height), block.type());
+			auto px = x * block_width;
+			auto py = y * block_height;
 
-			dct(block, trans);
+			if (src.depth() == CV_8U)
+			{
+				dct_load_block<uchar>(src, px, py, channel, block);
+			}
+			else
+			{
+				dct_load_block<float>(src, px, py, channel, block);
+			}
 
-			auto a = trans.at<float>(6, 7);
-			auto b = trans.at<float>(5, 1);
+			dct_extract_block(block, extracted, pairs);
 
-			if (a > b)
+			for (int j = 0; j < pairs; j++)
 			{
-				bits[i / 8] |= 1 << i % 8;
+				vals[(k - begin) * pairs + j] = uchar(extracted[j]);
 			}
+		}
+	});
 
-			i++;
+	for (auto i = max(first, begin * pairs); i < min(last, end * pairs); i++)
+	{
+		if (vals[i - begin * pairs])
+		{
+			bits[(i - first) / 8] |= 1 << i % 8;
 		}
 	}
 
 	return bits;
 }
+
+/*!
+ * Uses discrete cosine transformation to recover data hidden in the coefficients of an image.
+ *
+ * \param img Input image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param order Traversal order of the blocks, see DCT_ORDER_* constants.
+ * \param pairs Number of bits hidden per block, at most DCT_MAX_PAIRS.
+ * \param key Key of the order in which the blocks were visited, or an empty string for the traversal order.
+ *
+ * \return Hidden data extracted form image.
+ */
+inline std::string decode_dct(const cv::Mat& img, int channel = 0, int order = DCT_ORDER_ROWS, int pairs = 1, const std::string& key = "")
+{
+	return decode_dct_range(img, 0, int64_t(img.cols / Dct<8>::size) * (img.rows / Dct<8>::size) * pairs / 8, channel, order, pairs, key);
+}
+
+/*!
+ * Uses discrete cosine transformation to recover data encapsulated with `encode_tlv`.
+ * The header is extracted first, and only the blocks covered by the payload are transformed afterwards.
+ *
+ * \param img Input image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param order Traversal order of the blocks, see DCT_ORDER_* constants.
+ * \param pairs Number of bits hidden per block, at most DCT_MAX_PAIRS.
+ * \param key Key of the order in which the blocks were visited, or an empty string for the traversal order.
+ *
+ * \return Hidden data extracted form image, or an empty string if the header is invalid.
+ */
+inline std::string decode_dct_tlv(const cv::Mat& img, int channel = 0, int order = DCT_ORDER_ROWS, int pairs = 1, const std::string& key = "")
+{
+	return decode_tlv_lazy([&](int64_t offset, int64_t length) { return decode_dct_range(img, offset, length, channel, order, pairs, key); });
+}
@@ -0,0 +1,335 @@
+#pragma once
+#include <cmath>
+#include <csetjmp>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <jpeglib.h>
+#include "dct.hpp"
+
+/*!
+ * Error manager which returns control to the caller instead of terminating the process.
+ */
+struct dct_jpeg_error
+{
+	jpeg_error_mgr mgr;
+	jmp_buf jump;
+};
+
+/*!
+ * Handles fatal libjpeg errors by jumping back to the caller.
+ *
+ * \param info Compression or decompression object which failed.
+ */
+inline void dct_jpeg_error_exit(j_common_ptr info)
+{
+	longjmp(reinterpret_cast<dct_jpeg_error*>(info->err)->jump, 1);
+}
+
+/*!
+ * Hides a bit in the quantized coefficients (6,7) and (5,1) of a JPEG block.
+ * The ordering rule is applied to the dequantized values, the result is then
+ * quantized again and pushed apart by whole steps if rounding broke the order.
+ *
+ * \param block Quantized coefficients of the block in natural order.
+ * \param quant Quantization table of the component in natural order.
+ * \param val Bit to hide.
+ * \param intensity Persistence of the hidden data.
+ */
+inline void dct_jpeg_embed_block(JCOEF* block, const UINT16* quant, int val, int intensity)
+{
+	using namespace std;
+
+	auto qa = int(quant[6 * 8 + 7]);
+	auto qb = int(quant[5 * 8 + 1]);
+
+	auto a = float(block[6 * 8 + 7] * qa);
+	auto b = float(block[5 * 8 + 1] * qb);
+
+	dct_order_pair(a, b, val, intensity);
+
+	auto ca = int(lround(a / qa));
+	auto cb = int(lround(b / qb));
+
+	while (val == 1 && ca * qa <= cb * qb)
+	{
+		ca++;
+		cb--;
+	}
+
+	while (val == 0 && ca * qa >= cb * qb)
+	{
+		ca--;
+		cb++;
+	}
+
+	block[6 * 8 + 7] = JCOEF(ca);
+	block[5 * 8 + 1] = JCOEF(cb);
+}
+
+/*!
+ * Recovers the bit hidden in the quantized coefficients (6,7) and (5,1) of a JPEG block.
+ *
+ * \param block Quantized coefficients of the block in natural order.
+ * \param quant Quantization table of the component in natural order.
+ *
+ * \return Hidden bit.
+ */
+inline int dct_jpeg_extract_block(const JCOEF* block, const UINT16* quant)
+{
+	return block[6 * 8 + 7] * quant[6 * 8 + 7] > block[5 * 8 + 1] * quant[5 * 8 + 1] ? 1 : 0;
+}
+
+/*!
+ * Requests the comment and application markers of a JPEG file, such as EXIF
+ * and ICC profiles, to be kept in memory while its header is read.
+ *
+ * \param src Decompression object whose header was not read yet.
+ */
+inline void dct_jpeg_save_markers(j_decompress_ptr src)
+{
+	jpeg_save_markers(src, JPEG_COM, 0xFFFF);
+
+	for (int m = 0; m < 16; m++)
+	{
+		jpeg_save_markers(src, JPEG_APP0 + m, 0xFFFF);
+	}
+}
+
+/*!
+ * Writes the markers kept by `dct_jpeg_save_markers` to the altered file, as done by jpegtran.
+ * The JFIF and Adobe markers are skipped when libjpeg writes its own.
+ *
+ * \param src Decompression object with the saved markers.
+ * \param dst Compression object after the call to `jpeg_write_coefficients`.
+ */
+inline void dct_jpeg_copy_markers(j_decompress_ptr src, j_compress_ptr dst)
+{
+	for (auto marker = src->marker_list; marker != nullptr; marker = marker->next)
+	{
+		auto data = marker->data;
+		auto size = marker->data_length;
+
+		if (dst->write_JFIF_header && marker->marker == JPEG_APP0 && size >= 5 && data[0] == 'J' && data[1] == 'F' && data[2] == 'I' && data[3] == 'F' && data[4] == 0)
+		{
+			continue;
+		}
+
+		if (dst->write_Adobe_marker && marker->marker == JPEG_APP0 + 14 && size >= 5 && data[0] == 'A' && data[1] == 'd' && data[2] == 'o' && data[3] == 'b' && data[4] == 'e')
+		{
+			continue;
+		}
+
+		jpeg_write_marker(dst, marker->marker, data, size);
+	}
+}
+
+/*!
+ * Hides data in the quantized DCT coefficients of a JPEG file.
+ * The coefficients are read and written directly with libjpeg, so the image
+ * is neither decoded to pixels nor quantized again, and no additional
+ * generation loss is introduced. The comment and application markers, such as
+ * EXIF and ICC profiles, are copied to the altered file.
+ *
+ * \param input Path to the original JPEG file.
+ * \param output Path to write the altered JPEG file to.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param components Components to manipulate, 0 for luma, 1 and 2 for chroma.
+ * \param intensity Persistence of the hidden data.
+ * \param order Traversal order of the blocks, see DCT_ORDER_* constants.
+ *
+ * \return Value indicating whether the operation was successful.
+ */
+inline bool encode_dct_jpeg(const std::string& input, const std::string& output, const std::string& text, int mode = STORE_FULL, const std::vector<int>& components = std::vector<int> { 0 }, int intensity = 30, int order = DCT_ORDER_ROWS)
+{
+	auto src_file = fopen(input.c_str(), "rb");
+
+	if (!src_file)
+	{
+		return false;
+	}
+
+	auto dst_file = fopen(output.c_str(), "wb");
+
+	if (!dst_file)
+	{
+		fclose(src_file);
+		return false;
+	}
+
+	jpeg_decompress_struct src;
+	jpeg_compress_struct dst;
+	dct_jpeg_error err;
+
+	src.err = jpeg_std_error(&err.mgr);
+	dst.err = &err.mgr;
+	err.mgr.error_exit = dct_jpeg_error_exit;
+
+	jpeg_create_decompress(&src);
+	jpeg_create_compress(&dst);
+
+	if (setjmp(err.jump))
+	{
+		jpeg_destroy_compress(&dst);
+		jpeg_destroy_decompress(&src);
+		fclose(src_file);
+		fclose(dst_file);
+		remove(output.c_str());
+		return false;
+	}
+
+	jpeg_stdio_src(&src, src_file);
+	dct_jpeg_save_markers(&src);
+	jpeg_read_header(&src, TRUE);
+
+	auto coefs = jpeg_read_coefficients(&src);
+	auto size  = int64_t(text.length()) * 8;
+
+	for (auto ci : components)
+	{
+		if (ci < 0 || ci >= src.num_components)
+		{
+			continue;
+		}
+
+		auto comp     = &src.comp_info[ci];
+		auto quant    = comp->quant_table->quantval;
+		auto blocks_x = int(comp->width_in_blocks);
+		auto blocks_y = int(comp->height_in_blocks);
+
+		for (int y = 0; y < blocks_y; y++)
+		{
+			auto row = (*src.mem->access_virt_barray)(reinterpret_cast<j_common_ptr>(&src), coefs[ci], JDIMENSION(y), 1, TRUE);
+
+			for (int x = 0; x < blocks_x; x++)
+			{
+				auto i = dct_block_bit(dct_block_index(x, y, blocks_x, blocks_y, order), size, mode);
+
+				if (i < 0)
+				{
+					continue;
+				}
+
+				auto val = 0;
+				if (i < size)
+				{
+					val = (text[i / 8] & 1 << i % 8) >> i % 8;
+				}
+
+				dct_jpeg_embed_block(row[0][x], quant, val, intensity);
+			}
+		}
+	}
+
+	jpeg_copy_critical_parameters(&src, &dst);
+	jpeg_stdio_dest(&dst, dst_file);
+	jpeg_write_coefficients(&dst, coefs);
+	dct_jpeg_copy_markers(&src, &dst);
+
+	jpeg_finish_compress(&dst);
+	jpeg_finish_decompress(&src);
+
+	jpeg_destroy_compress(&dst);
+	jpeg_destroy_decompress(&src);
+
+	fclose(src_file);
+	fclose(dst_file);
+
+	return true;
+}
+
+/*!
+ * Recovers data hidden in the quantized DCT coefficients of a JPEG file.
+ * The output is a parameter, as locals of this function would be left
+ * indeterminate when libjpeg reports an error.
+ *
+ * \param input Path to the JPEG file with hidden data.
+ * \param component Component to read, 0 for luma, 1 and 2 for chroma.
+ * \param order Traversal order of the blocks, see DCT_ORDER_* constants.
+ * \param bits Destination of the data extracted from the file.
+ *
+ * \return Value indicating whether the operation was successful.
+ */
+inline bool decode_dct_jpeg(const std::string& input, int component, int order, std::string& bits)
+{
+	auto src_file = fopen(input.c_str(), "rb");
+
+	if (!src_file)
+	{
+		return false;
+	}
+
+	jpeg_decompress_struct src;
+	dct_jpeg_error err;
+
+	src.err = jpeg_std_error(&err.mgr);
+	err.mgr.error_exit = dct_jpeg_error_exit;
+
+	jpeg_create_decompress(&src);
+
+	if (setjmp(err.jump))
+	{
+		jpeg_destroy_decompress(&src);
+		fclose(src_file);
+		return false;
+	}
+
+	jpeg_stdio_src(&src, src_file);
+	jpeg_read_header(&src, TRUE);
+
+	auto coefs = jpeg_read_coefficients(&src);
+
+	if (component >= 0 && component < src.num_components)
+	{
+		auto comp     = &src.comp_info[component];
+		auto quant    = comp->quant_table->quantval;
+		auto blocks_x = int(comp->width_in_blocks);
+		auto blocks_y = int(comp->height_in_blocks);
+
+		bits.assign(size_t(blocks_x) * blocks_y / 8, 0);
+
+		for (int y = 0; y < blocks_y; y++)
+		{
+			auto row = (*src.mem->access_virt_barray)(reinterpret_cast<j_common_ptr>(&src), coefs[component], JDIMENSION(y), 1, FALSE);
+
+			for (int x = 0; x < blocks_x; x++)
+			{
+				auto i = dct_block_index(x, y, blocks_x, blocks_y, order);
+
+				if (i / 8 < int64_t(bits.size()) && dct_jpeg_extract_block(row[0][x], quant))
+				{
+					bits[i / 8] |= 1 << i % 8;
+				}
+			}
+		}
+	}
+
+	jpeg_finish_decompress(&src);
+	jpeg_destroy_decompress(&src);
+
+	fclose(src_file);
+
+	return true;
+}
+
+/*!
+ * Recovers data hidden in the quantized DCT coefficients of a JPEG file.
+ *
+ * \param input Path to the JPEG file with hidden data.
+ * \param component Component to read, 0 for luma, 1 and 2 for chroma.
+ * \param order Traversal order of the blocks, see DCT_ORDER_* constants.
+ *
+ * \return Hidden data extracted form the file, or an empty string on failure.
+ */
+inline std::string decode_dct_jpeg(const std::string& input, int component = 0, int order = DCT_ORDER_ROWS)
+{
+	std::string bits;
+
+	if (!decode_dct_jpeg(input, component, order, bits))
+	{
+		bits.clear();
+	}
+
+	return bits;
+}
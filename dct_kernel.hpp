@@ -0,0 +1,264 @@
+#pragma once
+#include <cmath>
+#include <vector>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define DCT_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define DCT_SSE2 1
+#endif
+
+/*!
+ * Orthonormal two-dimensional discrete cosine transformation of NxN blocks,
+ * producing the same coefficients as `cv::dct`.
+ *
+ * The block size is a compile-time constant, blocks are row-major arrays of
+ * N*N floats on the stack or in a workspace, and no memory is allocated per
+ * block. Rows are processed with AVX2 or SSE2 when available, otherwise with
+ * a scalar fallback.
+ *
+ * \tparam N Width and height of a block, 4, 8 or 16.
+ */
+template<int N>
+class Dct
+{
+	static_assert(N == 4 || N == 8 || N == 16, "Supported block sizes are 4, 8 and 16.");
+
+public:
+
+	/*!
+	 * Width and height of a block.
+	 */
+	static const int size = N;
+
+	/*!
+	 * Returns the transformation matrix, where row `k` holds the `k`th cosine basis vector.
+	 *
+	 * \return Row-major table of N*N weights.
+	 */
+	static const float* matrix()
+	{
+		return tables().data();
+	}
+
+	/*!
+	 * Returns the transposed transformation matrix.
+	 *
+	 * \return Row-major table of N*N weights.
+	 */
+	static const float* transposed()
+	{
+		return tables().data() + N * N;
+	}
+
+	/*!
+	 * Returns the basis image of the specified coefficient.
+	 * Projecting a spatial block onto this table yields the value of the coefficient.
+	 *
+	 * \param u Vertical frequency, row of the coefficient.
+	 * \param v Horizontal frequency, column of the coefficient.
+	 *
+	 * \return Row-major table of N*N weights.
+	 */
+	static const float* basis(int u, int v)
+	{
+		return tables().data() + (2 + u * N + v) * N * N;
+	}
+
+	/*!
+	 * Computes the dot product of a block and a table of the same size.
+	 *
+	 * \param block Row-major spatial block.
+	 * \param basis Basis image, see `basis`.
+	 *
+	 * \return Value of the coefficient.
+	 */
+	static float project(const float* block, const float* basis)
+	{
+#if DCT_AVX2
+
+		auto acc = _mm256_setzero_ps();
+
+		for (int i = 0; i < N * N; i += 8)
+		{
+			acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(block + i), _mm256_loadu_ps(basis + i)));
+		}
+
+		auto sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+		     sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		     sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+
+		return _mm_cvtss_f32(sum);
+
+#elif DCT_SSE2
+
+		auto acc = _mm_setzero_ps();
+
+		for (int i = 0; i < N * N; i += 4)
+		{
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(block + i), _mm_loadu_ps(basis + i)));
+		}
+
+		acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+		acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+
+		return _mm_cvtss_f32(acc);
+
+#else
+
+		auto sum = 0.f;
+
+		for (int i = 0; i < N * N; i++)
+		{
+			sum += block[i] * basis[i];
+		}
+
+		return sum;
+
+#endif
+	}
+
+	/*!
+	 * Performs the forward transformation.
+	 *
+	 * \param src Row-major spatial block.
+	 * \param dst Row-major coefficients, may not alias `src`.
+	 */
+	static void forward(const float* src, float* dst)
+	{
+		float tmp[N * N];
+
+		multiply(matrix(), src, tmp);
+		multiply(tmp, transposed(), dst);
+	}
+
+	/*!
+	 * Performs the inverse transformation.
+	 *
+	 * \param src Row-major coefficients.
+	 * \param dst Row-major spatial block, may not alias `src`.
+	 */
+	static void inverse(const float* src, float* dst)
+	{
+		float tmp[N * N];
+
+		multiply(transposed(), src, tmp);
+		multiply(tmp, matrix(), dst);
+	}
+
+private:
+
+	/*!
+	 * Returns the lazily built tables: the matrix, its transpose, then the N*N basis images.
+	 */
+	static const std::vector<float>& tables()
+	{
+		static const auto tables = []
+		{
+			const auto pi = 3.14159265358979323846;
+
+			std::vector<float> tables((2 + N * N) * N * N);
+			std::vector<double> cosines(N * N);
+
+			for (int k = 0; k < N; k++)
+			{
+				auto ak = k == 0 ? std::sqrt(1.0 / N) : std::sqrt(2.0 / N);
+
+				for (int n = 0; n < N; n++)
+				{
+					cosines[k * N + n] = ak * std::cos((2 * n + 1) * k * pi / (2 * N));
+
+					tables[k * N + n]         = float(cosines[k * N + n]);
+					tables[N * N + n * N + k] = float(cosines[k * N + n]);
+				}
+			}
+
+			for (int u = 0; u < N; u++)
+			{
+				for (int v = 0; v < N; v++)
+				{
+					auto table = &tables[(2 + u * N + v) * N * N];
+
+					for (int y = 0; y < N; y++)
+					{
+						for (int x = 0; x < N; x++)
+						{
+							table[y * N + x] = float(cosines[u * N + y] * cosines[v * N + x]);
+						}
+					}
+				}
+			}
+
+			return tables;
+		}();
+
+		return tables;
+	}
+
+	/*!
+	 * Multiplies two NxN matrices by accumulating broadcast elements of `a` with rows of `b`.
+	 *
+	 * \param a Left operand.
+	 * \param b Right operand.
+	 * \param c Result, may not alias the operands.
+	 */
+	static void multiply(const float* a, const float* b, float* c)
+	{
+		for (int i = 0; i < N; i++)
+		{
+#if DCT_AVX2
+
+			if (N % 8 == 0)
+			{
+				for (int j = 0; j < N; j += 8)
+				{
+					auto acc = _mm256_setzero_ps();
+
+					for (int k = 0; k < N; k++)
+					{
+						acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(a[i * N + k]), _mm256_loadu_ps(b + k * N + j)));
+					}
+
+					_mm256_storeu_ps(c + i * N + j, acc);
+				}
+
+				continue;
+			}
+
+#endif
+#if DCT_SSE2
+
+			for (int j = 0; j < N; j += 4)
+			{
+				auto acc = _mm_setzero_ps();
+
+				for (int k = 0; k < N; k++)
+				{
+					acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(a[i * N + k]), _mm_loadu_ps(b + k * N + j)));
+				}
+
+				_mm_storeu_ps(c + i * N + j, acc);
+			}
+
+#else
+
+			for (int j = 0; j < N; j++)
+			{
+				auto acc = 0.f;
+
+				for (int k = 0; k < N; k++)
+				{
+					acc += a[i * N + k] * b[k * N + j];
+				}
+
+				c[i * N + j] = acc;
+			}
+
+#endif
+		}
+	}
+};
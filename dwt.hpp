@@ -2,17 +2,70 @@
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/highgui.hpp>
-#include <tuple>
+#include <cfloat>
+#include "helpers.hpp"
+#include "dwt_kernel.hpp"
+#include "permutation.hpp"
+#include "tlv.hpp"
 
 /*!
- * Performs Haar wavelet decomposition.
+ * Subband holding the approximation coefficients.
+ */
+#define DWT_APPROXIMATION 0
+
+/*!
+ * Subband holding the horizontal detail coefficients.
+ */
+#define DWT_HORIZONTAL    1
+
+/*!
+ * Subband holding the vertical detail coefficients.
+ */
+#define DWT_VERTICAL      2
+
+/*!
+ * Subband holding the diagonal detail coefficients.
+ */
+#define DWT_DIAGONAL      3
+
+/*!
+ * Maximum number of decomposition levels supported by the multi-level functions.
+ */
+#define DWT_MAX_LEVELS    4
+
+/*!
+ * Returns a view of a subband within a Haar wavelet decomposition.
+ * The view shares the memory of the decomposition, so changes to it are
+ * picked up by `cvInvHaarWavelet` and `dwt_reconstruct`.
+ *
+ * \param haar Decomposition produced by `cvHaarWavelet` or `dwt_decompose`.
+ * \param band Subband to return, see DWT_* constants.
+ * \param level Decomposition level of the subband, starting from 1.
+ *
+ * \return Quadrant of the decomposition holding the subband.
+ */
+inline cv::Mat dwt_subband(const cv::Mat& haar, int band, int level = 1)
+{
+	using namespace cv;
+
+	auto width  = haar.cols >> level;
+	auto height = haar.rows >> level;
+
+	return haar(Rect(band & 1 ? width : 0, band & 2 ? height : 0, width, height));
+}
+
+/*!
+ * Performs Haar wavelet decomposition, see `haar_forward_rows`.
+ * The approximation is written to the top-left quadrant of the destination,
+ * the horizontal, vertical and diagonal coefficients to the top-right,
+ * bottom-left and bottom-right quadrants, see `dwt_subband`.
  *
  * \param src Source image.
  * \param dst Destination image for the decomposition.
- *
- * \return Tuple with the horizontal, vertical and diagonal coefficients.
+ * \param lower Values of the source below this are clamped before the decomposition.
+ * \param upper Values of the source above this are clamped before the decomposition.
  */
-inline std::tuple<std::vector<std::vector<float>>, std::vector<std::vector<float>>, std::vector<std::vector<float>>> cvHaarWavelet(const cv::Mat& src, cv::Mat& dst)
+inline void cvHaarWavelet(const cv::Mat& src, cv::Mat& dst, float lower = -FLT_MAX, float upper = FLT_MAX)
 {
 	using namespace cv;
 	using namespace std;
@@ -20,47 +73,24 @@ inline std::tuple<std::vector<std::vector<float>>, std::vector<std::vector<float
 	auto width  = src.cols / 2;
 	auto height = src.rows / 2;
 
-	vector<vector<float>> dhs(height);
-	vector<vector<float>> dvs(height);
-	vector<vector<float>> dds(height);
+	dst.create(src.rows, src.cols, CV_32FC1);
 
 	for (int y = 0; y < height; y++)
 	{
-		dhs[y] = vector<float>(width);
-		dvs[y] = vector<float>(width);
-		dds[y] = vector<float>(width);
+		auto top    = dst.ptr<float>(y);
+		auto bottom = dst.ptr<float>(y + height);
 
-		for (int x = 0; x<(width);x++)
-		{
-			auto c  = (src.at<float>(2 * y, 2 * x) + src.at<float>(2 * y, 2 * x + 1) + src.at<float>(2 * y + 1, 2 * x) + src.at<float>(2 * y + 1, 2 * x + 1)) * 0.5;
-			auto dh = (src.at<float>(2 * y, 2 * x) + src.at<float>(2 * y + 1, 2 * x) - src.at<float>(2 * y, 2 * x + 1) - src.at<float>(2 * y + 1, 2 * x + 1)) * 0.5;
-			auto dv = (src.at<float>(2 * y, 2 * x) + src.at<float>(2 * y, 2 * x + 1) - src.at<float>(2 * y + 1, 2 * x) - src.at<float>(2 * y + 1, 2 * x + 1)) * 0.5;
-			auto dd = (src.at<float>(2 * y, 2 * x) - src.at<float>(2 * y, 2 * x + 1) - src.at<float>(2 * y + 1, 2 * x) + src.at<float>(2 * y + 1, 2 * x + 1)) * 0.5;
-
-			dst.at<float>(y,          x)         = c;
-			dst.at<float>(y,          x + width) = dh;
-			dst.at<float>(y + height, x)         = dv;
-			dst.at<float>(y + height, x + width) = dd;
-
-			dhs[y][x] = dh;
-			dvs[y][x] = dv;
-			dds[y][x] = dd;
-		}
+		haar_forward_rows(src.ptr<float>(2 * y), src.ptr<float>(2 * y + 1), top, top + width, bottom, bottom + width, width, lower, upper);
 	}
-
-	return make_tuple(dhs, dvs, dds);
 }
 
 /*!
- * Performs Haar wavelet reconstruction.
+ * Performs Haar wavelet reconstruction, see `haar_inverse_rows`.
  *
- * \param src Source image.
+ * \param src Decomposition produced by `cvHaarWavelet`, with optionally altered subbands.
  * \param dst Destination image for the reconstruction.
- * \param dhs Horizontal coefficients.
- * \param dvs Vertical coefficients.
- * \param dds Diagonal coefficients.
  */
-inline void cvInvHaarWavelet(const cv::Mat& src, cv::Mat& dst, const std::vector<std::vector<float>>& dhs, const std::vector<std::vector<float>>& dvs, const std::vector<std::vector<float>>& dds)
+inline void cvInvHaarWavelet(const cv::Mat& src, cv::Mat& dst)
 {
 	using namespace cv;
 	using namespace std;
@@ -70,111 +100,546 @@ inline void cvInvHaarWavelet(const cv::Mat& src, cv::Mat& dst, const std::vector
 
 	for (int y = 0; y < height; y++)
 	{
-		for (int x = 0; x < width; x++)
+		auto top    = src.ptr<float>(y);
+		auto bottom = src.ptr<float>(y + height);
+
+		haar_inverse_rows(top, top + width, bottom, bottom + width, dst.ptr<float>(y * 2), dst.ptr<float>(y * 2 + 1), width);
+	}
+}
+
+/*!
+ * Performs multi-level Haar wavelet decomposition, by decomposing the
+ * approximation of each level again in-place. The subbands of each level
+ * can be accessed with `dwt_subband`.
+ *
+ * \param src Source image.
+ * \param dst Destination image for the decomposition.
+ * \param levels Number of decomposition levels.
+ * \param lower Values of the source below this are clamped before the decomposition.
+ * \param upper Values of the source above this are clamped before the decomposition.
+ */
+inline void dwt_decompose(const cv::Mat& src, cv::Mat& dst, int levels, float lower = -FLT_MAX, float upper = FLT_MAX)
+{
+	using namespace cv;
+
+	cvHaarWavelet(src, dst, lower, upper);
+
+	for (int level = 1; level < levels; level++)
+	{
+		auto approx = dwt_subband(dst, DWT_APPROXIMATION, level);
+
+		Mat haar = approx.clone();
+		cvHaarWavelet(approx, haar);
+		haar.copyTo(approx);
+	}
+}
+
+/*!
+ * Performs multi-level Haar wavelet reconstruction, the reverse of `dwt_decompose`.
+ *
+ * \param src Decomposition produced by `dwt_decompose`, with optionally altered subbands.
+ *            The deeper levels are reconstructed in-place, so it is overwritten.
+ * \param dst Destination image for the reconstruction.
+ * \param levels Number of decomposition levels.
+ */
+inline void dwt_reconstruct(cv::Mat& src, cv::Mat& dst, int levels)
+{
+	using namespace cv;
+
+	for (int level = levels - 1; level >= 1; level--)
+	{
+		auto approx = dwt_subband(src, DWT_APPROXIMATION, level);
+
+		Mat haar = approx.clone();
+		cvInvHaarWavelet(approx, haar);
+		haar.copyTo(approx);
+	}
+
+	cvInvHaarWavelet(src, dst);
+}
+
+/*!
+ * Hides data in the coefficients of subbands, one bit per coefficient,
+ * in row-major order within each subband and continuing with the next subband.
+ *
+ * \param bands Subbands to manipulate in-place, see `dwt_subband`.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param embed Function returning the altered value of a coefficient for a bit and the index of its subband.
+ * \param first Index of the first coefficient within the whole image, when only a part of it is processed.
+ * \param order Permutation of the coefficients of the whole image, coefficient `order(i)` carrying bit `i`.
+ */
+template<typename Embed>
+inline void dwt_embed_subbands(std::vector<cv::Mat>& bands, const std::string& text, int mode, Embed embed, int64_t first = 0, const Permutation& order = Permutation())
+{
+	auto i = first;
+	auto size = int64_t(text.length()) * 8;
+
+	if (!order.identity())
+	{
+		for (size_t b = 0; b < bands.size(); b++)
 		{
-			auto dh = dhs[y][x];
-			auto dv = dvs[y][x];
-			auto dd = dds[y][x];
+			for (int y = 0; y < bands[b].rows; y++)
+			{
+				auto row = bands[b].ptr<float>(y);
 
-			auto c = src.at<float>(y, x);
+				for (int x = 0; x < bands[b].cols; x++)
+				{
+					auto k = int64_t(order.inverse(uint64_t(i++)));
+
+					if (k >= size)
+					{
+						if (mode == STORE_ONCE)
+						{
+							continue;
+						}
+						else if (mode == STORE_REPEAT && size > 0)
+						{
+							k %= size;
+						}
+					}
+
+					auto val = 0;
+					if (k < size)
+					{
+						val = (text[k / 8] & 1 << k % 8) >> k % 8;
+					}
+
+					row[x] = embed(row[x], val, b);
+				}
+			}
+		}
+
+		return;
+	}
 
-			dst.at<float>(y * 2,     x * 2)     = 0.5 * (c + dh + dv + dd);
-			dst.at<float>(y * 2,     x * 2 + 1) = 0.5 * (c - dh + dv - dd);
-			dst.at<float>(y * 2 + 1, x * 2)     = 0.5 * (c + dh - dv - dd);
-			dst.at<float>(y * 2 + 1, x * 2 + 1) = 0.5 * (c - dh - dv + dd);
+	if (i >= size && mode == STORE_REPEAT)
+	{
+		i = size > 0 ? i % size : size;
+	}
+
+	for (size_t b = 0; b < bands.size(); b++)
+	{
+		for (int y = 0; y < bands[b].rows; y++)
+		{
+			auto row = bands[b].ptr<float>(y);
+
+			for (int x = 0; x < bands[b].cols; x++)
+			{
+				if (i >= size)
+				{
+					if (mode == STORE_ONCE)
+					{
+						return;
+					}
+					else if (mode == STORE_REPEAT)
+					{
+						i = 0;
+					}
+				}
+
+				auto val = 0;
+				if (i < size)
+				{
+					val = (text[i / 8] & 1 << i % 8) >> i % 8;
+					i++;
+				}
+
+				row[x] = embed(row[x], val, b);
+			}
 		}
 	}
 }
 
 /*!
- * Uses discrete wavelet transformation to hide data in the diagonal filter of a channel of an image.
+ * Hides data in the diagonal filter of a channel of an image.
  *
  * \param img Input image.
  * \param text Text to hide.
  * \param mode Storage mode, see STORE_* constants.
  * \param channel Channel to manipulate.
- * \param alpha Encoding intensity.
+ * \param margin Values of the channel are clamped this far from black and white,
+ *               so the altered coefficients do not saturate the pixels.
+ * \param embed Function returning the altered value of a coefficient for a bit.
+ * \param first Index of the first diagonal coefficient within the whole image, when only a strip of it is processed.
+ * \param order Permutation of the diagonal coefficients of the whole image.
  *
  * \return Altered image with hidden data.
  */
-inline cv::Mat encode_dwt(const cv::Mat& img, const std::string& text, int mode = STORE_FULL, int channel = 0, float alpha = 0.1)
+template<typename Embed>
+inline cv::Mat dwt_encode_diagonal(const cv::Mat& img, const std::string& text, int mode, int channel, float margin, Embed embed, int64_t first = 0, const Permutation& order = Permutation())
 {
 	using namespace cv;
 	using namespace std;
 
-	auto i = 0;
-	auto size = text.length() * 8;
-
 	Mat imgfp;
 	img.convertTo(imgfp, CV_32F, 1.0 / 255);
 
 	vector<Mat> planes;
 	split(imgfp, planes);
 
-	for (int y = 0;y < img.cols; y++)
+	Mat haar;
+	cvHaarWavelet(planes[channel], haar, margin, 1 - margin);
+
+	vector<Mat> bands { dwt_subband(haar, DWT_DIAGONAL) };
+
+	dwt_embed_subbands(bands, text, mode, [&](float c, int val, size_t) { return embed(c, val); }, first, order);
+
+	cvInvHaarWavelet(haar, planes[channel]);
+
+	Mat mergedfp;
+	merge(planes, mergedfp);
+
+	Mat merged;
+	mergedfp.convertTo(merged, CV_8U, 255);
+
+	return merged;
+}
+
+/*!
+ * Returns the diagonal coefficients of a range of rows within a channel of an image.
+ *
+ * \param img Input image.
+ * \param top First row of the subband to compute.
+ * \param rows Number of rows of the subband to compute.
+ * \param channel Channel to transform.
+ *
+ * \return Diagonal coefficients, the first row corresponding to `top`.
+ */
+inline cv::Mat dwt_diagonal_rows(const cv::Mat& img, int top, int rows, int channel)
+{
+	using namespace cv;
+	using namespace std;
+
+	Mat imgfp;
+	img.rowRange(top * 2, (top + rows) * 2).convertTo(imgfp, CV_32F, 1.0 / 255);
+
+	vector<Mat> planes;
+	split(imgfp, planes);
+
+	Mat haar;
+	cvHaarWavelet(planes[channel], haar);
+
+	return dwt_subband(haar, DWT_DIAGONAL);
+}
+
+/*!
+ * Uses discrete wavelet transformation to hide data in the diagonal filter of a channel of an image.
+ *
+ * \param img Input image.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param channel Channel to manipulate.
+ * \param alpha Encoding intensity.
+ * \param key Key of the pseudo-random order in which the coefficients are visited, or an empty string for raster order.
+ *
+ * \return Altered image with hidden data.
+ */
+inline cv::Mat encode_dwt(const cv::Mat& img, const std::string& text, int mode = STORE_FULL, int channel = 0, float alpha = 0.1, const std::string& key = "")
+{
+	return dwt_encode_diagonal(img, text, mode, channel, alpha, [=](float c, int val) { return val == 1 ? c + alpha : c - alpha; }, 0, Permutation(uint64_t(img.cols / 2) * (img.rows / 2), key));
+}
+
+/*!
+ * Recovers a range of the data hidden in the diagonal filter of an image.
+ * Each bit is the sign of the difference between the diagonal coefficients
+ * of the altered and the original image. Only the rows of the altered image
+ * carrying the requested bytes are transformed.
+ *
+ * \param stego Altered image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ * \param channel Channel to manipulate.
+ * \param cover Function returning the diagonal coefficients of the original
+ *              image for the specified first row and number of rows, or an
+ *              empty matrix for extraction without the original image.
+ * \param order Permutation of the diagonal coefficients, with which all rows are transformed
+ *              unless it is the identity, as the requested bits are scattered over the image.
+ *
+ * \return Hidden data extracted form image, shorter than requested if the image is too small.
+ */
+template<typename Cover>
+inline std::string dwt_decode_range(const cv::Mat& stego, int64_t offset, int64_t length, int channel, Cover cover, const Permutation& order = Permutation())
+{
+	using namespace cv;
+	using namespace std;
+
+	auto width    = stego.cols / 2;
+	auto height   = stego.rows / 2;
+	auto capacity = int64_t(width) * height / 8;
+
+	string bits(size_t(max(int64_t(0), min(length, capacity - offset))), 0);
+
+	if (bits.empty())
 	{
-		for (int x = 0; x < img.cols; x++)
-		{
-			auto val = planes[channel].at<float>(y, x);
+		return bits;
+	}
 
-			if (val < alpha)
-			{
-				val = alpha;
-			}
-			else if (val > 1 - alpha)
-			{
-				val = 1 - alpha;
-			}
+	auto first = offset * 8;
+	auto last  = first + int64_t(bits.size()) * 8;
+	auto top   = order.identity() ? int(first / width) : 0;
+	auto rows  = order.identity() ? int((last - 1) / width) - top + 1 : height;
 
-			planes[channel].at<float>(y, x) = val;
+	Mat dds1 = cover(top, rows);
+	Mat dds2 = dwt_diagonal_rows(stego, top, rows, channel);
+
+	for (auto i = first; i < last; i++)
+	{
+		auto j = int64_t(order(uint64_t(i)));
+		auto y = int(j / width) - top;
+		auto x = int(j % width);
+
+		auto val = dds2.at<float>(y, x);
+
+		if (!dds1.empty())
+		{
+			val -= dds1.at<float>(y, x);
+		}
+
+		if (val > 0)
+		{
+			bits[(i - first) / 8] |= 1 << i % 8;
 		}
 	}
 
-	Mat haar(img.rows, img.cols, CV_32FC1);
+	return bits;
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover a range of the data hidden in the diagonal filter of an image.
+ * Only the rows of the images carrying the requested bytes are transformed.
+ *
+ * \param img Original image without hidden data.
+ * \param stego Altered image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ * \param channel Channel to manipulate.
+ * \param key Key of the order in which the coefficients were visited, or an empty string for raster order.
+ *
+ * \return Hidden data extracted form image, shorter than requested if the image is too small.
+ */
+inline std::string decode_dwt_range(const cv::Mat& img, const cv::Mat& stego, int64_t offset, int64_t length, int channel = 0, const std::string& key = "")
+{
+	return dwt_decode_range(stego, offset, length, channel, [&](int top, int rows) { return dwt_diagonal_rows(img, top, rows, channel); }, Permutation(uint64_t(stego.cols / 2) * (stego.rows / 2), key));
+}
 
-	auto hwv = cvHaarWavelet(planes[channel], haar);
-	auto dds = get<2>(hwv);
+/*!
+ * Uses discrete wavelet transformation to recover data hidden in the diagonal filter of an image.
+ *
+ * \param img Original image without hidden data.
+ * \param stego Altered image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param key Key of the order in which the coefficients were visited, or an empty string for raster order.
+ *
+ * \return Hidden data extracted form image.
+ */
+inline std::string decode_dwt(const cv::Mat& img, const cv::Mat& stego, int channel = 0, const std::string& key = "")
+{
+	return decode_dwt_range(img, stego, 0, int64_t(img.cols / 2) * (img.rows / 2) / 8, channel, key);
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover data encapsulated with `encode_tlv`.
+ * The header is extracted first, and only the rows covered by the payload are transformed afterwards.
+ *
+ * \param img Original image without hidden data.
+ * \param stego Altered image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param key Key of the order in which the coefficients were visited, or an empty string for raster order.
+ *
+ * \return Hidden data extracted form image, or an empty string if the header is invalid.
+ */
+inline std::string decode_dwt_tlv(const cv::Mat& img, const cv::Mat& stego, int channel = 0, const std::string& key = "")
+{
+	return decode_tlv_lazy([&](int64_t offset, int64_t length) { return decode_dwt_range(img, stego, offset, length, channel, key); });
+}
+
+/*!
+ * Quantizes a coefficient by its sign according to the specified bit.
+ * Coefficients already at least `alpha` away from zero on the side of the bit
+ * are left untouched, others are moved to `alpha` or `-alpha`. Compression
+ * mostly attenuates the detail coefficients, which shrinks them towards zero
+ * but rarely flips their sign.
+ *
+ * \param c Coefficient to quantize.
+ * \param val Bit to hide.
+ * \param alpha Encoding intensity.
+ *
+ * \return Quantized coefficient.
+ */
+inline float dwt_blind_embed(float c, int val, float alpha)
+{
+	using namespace std;
+
+	return val == 1 ? max(c, alpha) : min(c, -alpha);
+}
 
-	for (int y = 0; y < dds.size(); y++)
+/*!
+ * Uses discrete wavelet transformation to hide data in the diagonal filter of
+ * a channel of an image, which can be recovered without the original image.
+ *
+ * \param img Input image.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param channel Channel to manipulate.
+ * \param alpha Encoding intensity.
+ * \param key Key of the pseudo-random order in which the coefficients are visited, or an empty string for raster order.
+ *
+ * \return Altered image with hidden data.
+ */
+inline cv::Mat encode_dwt_blind(const cv::Mat& img, const std::string& text, int mode = STORE_FULL, int channel = 0, float alpha = 0.1, const std::string& key = "")
+{
+	return dwt_encode_diagonal(img, text, mode, channel, alpha, [=](float c, int val) { return dwt_blind_embed(c, val, alpha); }, 0, Permutation(uint64_t(img.cols / 2) * (img.rows / 2), key));
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover a range of the data hidden in the diagonal filter of an image
+ * with `encode_dwt_blind`. Only the rows of the image carrying the requested bytes are transformed.
+ *
+ * \param stego Altered image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ * \param channel Channel to manipulate.
+ * \param key Key of the order in which the coefficients were visited, or an empty string for raster order.
+ *
+ * \return Hidden data extracted form image, shorter than requested if the image is too small.
+ */
+inline std::string decode_dwt_blind_range(const cv::Mat& stego, int64_t offset, int64_t length, int channel = 0, const std::string& key = "")
+{
+	return dwt_decode_range(stego, offset, length, channel, [](int, int) { return cv::Mat(); }, Permutation(uint64_t(stego.cols / 2) * (stego.rows / 2), key));
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover data hidden in the diagonal filter of an image
+ * with `encode_dwt_blind`.
+ *
+ * \param stego Altered image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param key Key of the order in which the coefficients were visited, or an empty string for raster order.
+ *
+ * \return Hidden data extracted form image.
+ */
+inline std::string decode_dwt_blind(const cv::Mat& stego, int channel = 0, const std::string& key = "")
+{
+	return decode_dwt_blind_range(stego, 0, int64_t(stego.cols / 2) * (stego.rows / 2) / 8, channel, key);
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover data encapsulated with `encode_tlv` and hidden
+ * with `encode_dwt_blind`. The header is extracted first, and only the rows covered by the payload
+ * are transformed afterwards.
+ *
+ * \param stego Altered image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param key Key of the order in which the coefficients were visited, or an empty string for raster order.
+ *
+ * \return Hidden data extracted form image, or an empty string if the header is invalid.
+ */
+inline std::string decode_dwt_blind_tlv(const cv::Mat& stego, int channel = 0, const std::string& key = "")
+{
+	return decode_tlv_lazy([&](int64_t offset, int64_t length) { return decode_dwt_blind_range(stego, offset, length, channel, key); });
+}
+
+/*!
+ * Returns the detail subbands of a multi-level decomposition in the order data is hidden in them:
+ * the horizontal, vertical and diagonal subbands of the first level, followed by those of the next levels.
+ *
+ * \param haar Decomposition produced by `dwt_decompose`.
+ * \param levels Number of decomposition levels.
+ * \param strengths Encoding intensities of the horizontal, vertical and diagonal subbands,
+ *                  subbands with an intensity of zero are skipped.
+ * \param alphas Optional destination of the encoding intensity of each returned subband.
+ *
+ * \return Views of the subbands within the decomposition.
+ */
+inline std::vector<cv::Mat> dwt_detail_subbands(const cv::Mat& haar, int levels, const cv::Vec3f& strengths, std::vector<float>* alphas = nullptr)
+{
+	using namespace cv;
+	using namespace std;
+
+	vector<Mat> bands;
+
+	for (int level = 1; level <= levels; level++)
 	{
-		for (int x = 0; x < dds[y].size(); x++)
+		for (int band = DWT_HORIZONTAL; band <= DWT_DIAGONAL; band++)
 		{
-			if (i >= size)
+			if (strengths[band - 1] <= 0)
 			{
-				if (mode == STORE_ONCE)
-				{
-					break;
-				}
-				else if (mode == STORE_REPEAT)
-				{
-					i = 0;
-				}
+				continue;
 			}
 
-			auto val = 0;
-			if (i < size)
-			{
-				val = (text[i / 8] & 1 << i % 8) >> i % 8;
-				i++;
-			}
+			bands.push_back(dwt_subband(haar, band, level));
 
-			if (val == 1)
+			if (alphas)
 			{
-				dds[y][x] += alpha;
-			}
-			else
-			{
-				dds[y][x] -= alpha;
+				alphas->push_back(strengths[band - 1]);
 			}
 		}
+	}
 
-		if (i >= size && mode == STORE_ONCE)
-		{
-			break;
-		}
+	return bands;
+}
+
+/*!
+ * Returns how far from black and white the values of a channel are clamped before hiding data
+ * in multiple subbands, so the altered coefficients do not saturate the pixels. A coefficient
+ * of level n altered by alpha changes each pixel it covers by at most alpha / 2^n.
+ *
+ * \param levels Number of decomposition levels.
+ * \param strengths Encoding intensities of the horizontal, vertical and diagonal subbands.
+ *
+ * \return Margin of the values, at most 0.5.
+ */
+inline float dwt_margin(int levels, const cv::Vec3f& strengths)
+{
+	using namespace std;
+
+	auto margin = 0.f;
+
+	for (int level = 1; level <= levels; level++)
+	{
+		margin += (max(strengths[0], 0.f) + max(strengths[1], 0.f) + max(strengths[2], 0.f)) / (1 << level);
 	}
 
-	cvInvHaarWavelet(haar, planes[channel], get<0>(hwv), get<1>(hwv), dds);
+	return min(margin, 0.5f);
+}
+
+/*!
+ * Hides data in the detail subbands of multiple decomposition levels of a channel of an image.
+ *
+ * \param img Input image.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param channel Channel to manipulate.
+ * \param levels Number of decomposition levels.
+ * \param strengths Encoding intensities of the horizontal, vertical and diagonal subbands.
+ * \param embed Function returning the altered value of a coefficient for a bit and the intensity of its subband.
+ *
+ * \return Altered image with hidden data.
+ */
+template<typename Embed>
+inline cv::Mat dwt_encode_subbands(const cv::Mat& img, const std::string& text, int mode, int channel, int levels, const cv::Vec3f& strengths, Embed embed)
+{
+	using namespace cv;
+	using namespace std;
+
+	Mat imgfp;
+	img.convertTo(imgfp, CV_32F, 1.0 / 255);
+
+	vector<Mat> planes;
+	split(imgfp, planes);
+
+	auto margin = dwt_margin(levels, strengths);
+
+	Mat haar;
+	dwt_decompose(planes[channel], haar, levels, margin, 1 - margin);
+
+	vector<float> alphas;
+	auto bands = dwt_detail_subbands(haar, levels, strengths, &alphas);
+
+	dwt_embed_subbands(bands, text, mode, [&](float c, int val, size_t b) { return embed(c, val, alphas[b]); });
+
+	dwt_reconstruct(haar, planes[channel], levels);
 
 	Mat mergedfp;
 	merge(planes, mergedfp);
@@ -186,54 +651,224 @@ inline cv::Mat encode_dwt(const cv::Mat& img, const std::string& text, int mode
 }
 
 /*!
- * Uses discrete wavelet transformation to recover data hidden in the diagonal filter of an image.
+ * Returns the multi-level decomposition of a channel of an image.
  *
- * \param img Original image without hidden data.
- * \param stego Altered image with hidden data.
- * \param channel Channel to manipulate.
+ * \param img Input image.
+ * \param channel Channel to transform.
+ * \param levels Number of decomposition levels.
+ * \param margin Values of the channel are clamped this far from black and white, see `dwt_margin`.
  *
- * \return Hidden data extracted form image.
+ * \return Decomposition of the channel, see `dwt_decompose`.
  */
-inline std::string decode_dwt(const cv::Mat& img, const cv::Mat& stego, int channel = 0)
+inline cv::Mat dwt_decompose_channel(const cv::Mat& img, int channel, int levels, float margin = 0)
 {
 	using namespace cv;
 	using namespace std;
 
-	auto i = 0;
-	string bits((img.cols / 2) * (img.rows  / 2) / 8, 0);
-
 	Mat imgfp;
 	img.convertTo(imgfp, CV_32F, 1.0 / 255);
 
-	Mat stegofp;
-	stego.convertTo(stegofp, CV_32F, 1.0 / 255);
+	vector<Mat> planes;
+	split(imgfp, planes);
+
+	Mat haar;
+
+	if (margin > 0)
+	{
+		dwt_decompose(planes[channel], haar, levels, margin, 1 - margin);
+	}
+	else
+	{
+		dwt_decompose(planes[channel], haar, levels);
+	}
+
+	return haar;
+}
+
+/*!
+ * Recovers a range of the data hidden in subbands with `dwt_embed_subbands`.
+ * Each bit is the sign of the altered coefficient, or of its difference from
+ * the coefficient of the original image, when available.
+ *
+ * \param stego Subbands of the altered image, see `dwt_detail_subbands`.
+ * \param cover Subbands of the original image, or empty for extraction without the original image.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ *
+ * \return Hidden data extracted form the subbands, shorter than requested if they are too small.
+ */
+inline std::string dwt_extract_subbands(const std::vector<cv::Mat>& stego, const std::vector<cv::Mat>& cover, int64_t offset, int64_t length)
+{
+	using namespace cv;
+	using namespace std;
 
-	vector<Mat> planes1;
-	split(imgfp, planes1);
+	auto capacity = int64_t(0);
 
-	vector<Mat> planes2;
-	split(stegofp, planes2);
+	for (auto& band : stego)
+	{
+		capacity += int64_t(band.rows) * band.cols;
+	}
 
-	Mat haar1(img.rows, img.cols, CV_32FC1);
-	Mat haar2(img.rows, img.cols, CV_32FC1);
+	string bits(size_t(max(int64_t(0), min(length, capacity / 8 - offset))), 0);
 
-	auto dds1 = get<2>(cvHaarWavelet(planes1[channel], haar1));
-	auto dds2 = get<2>(cvHaarWavelet(planes2[channel], haar2));
+	auto first = offset * 8;
+	auto last  = first + int64_t(bits.size()) * 8;
+	auto base  = int64_t(0);
 
-	for (int y = 0; y < dds1.size(); y++)
+	for (size_t b = 0; b < stego.size() && base < last; b++)
 	{
-		for (int x = 0; x < dds1[y].size(); x++)
+		auto width = stego[b].cols;
+		auto count = int64_t(stego[b].rows) * width;
+
+		for (auto i = max(first, base); i < min(last, base + count); i++)
 		{
-			auto val = dds2[y][x] - dds1[y][x];
+			auto y = int((i - base) / width);
+			auto x = int((i - base) % width);
 
-			if (val > 0)
+			auto val = stego[b].at<float>(y, x);
+
+			if (!cover.empty())
 			{
-				bits[i / 8] |= 1 << i % 8;
+				val -= cover[b].at<float>(y, x);
 			}
 
-			i++;
+			if (val > 0)
+			{
+				bits[(i - first) / 8] |= 1 << i % 8;
+			}
 		}
+
+		base += count;
 	}
 
 	return bits;
 }
+
+/*!
+ * Uses discrete wavelet transformation to hide data in the horizontal, vertical and diagonal filters
+ * of one or more decomposition levels of a channel of an image.
+ *
+ * \param img Input image.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param channel Channel to manipulate.
+ * \param levels Number of decomposition levels, up to DWT_MAX_LEVELS.
+ * \param strengths Encoding intensities of the horizontal, vertical and diagonal filters,
+ *                  filters with an intensity of zero are not used.
+ *
+ * \return Altered image with hidden data.
+ */
+inline cv::Mat encode_dwt_multi(const cv::Mat& img, const std::string& text, int mode = STORE_FULL, int channel = 0, int levels = 1, const cv::Vec3f& strengths = cv::Vec3f(0.1f, 0.1f, 0.1f))
+{
+	return dwt_encode_subbands(img, text, mode, channel, levels, strengths, [](float c, int val, float alpha) { return val == 1 ? c + alpha : c - alpha; });
+}
+
+/*!
+ * Uses discrete wavelet transformation to hide data in the horizontal, vertical and diagonal filters
+ * of one or more decomposition levels of a channel of an image, which can be recovered without the
+ * original image, see `dwt_blind_embed`.
+ *
+ * \param img Input image.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param channel Channel to manipulate.
+ * \param levels Number of decomposition levels, up to DWT_MAX_LEVELS.
+ * \param strengths Encoding intensities of the horizontal, vertical and diagonal filters,
+ *                  filters with an intensity of zero are not used.
+ *
+ * \return Altered image with hidden data.
+ */
+inline cv::Mat encode_dwt_multi_blind(const cv::Mat& img, const std::string& text, int mode = STORE_FULL, int channel = 0, int levels = 1, const cv::Vec3f& strengths = cv::Vec3f(0.1f, 0.1f, 0.1f))
+{
+	return dwt_encode_subbands(img, text, mode, channel, levels, strengths, dwt_blind_embed);
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover data hidden with `encode_dwt_multi`.
+ *
+ * \param img Original image without hidden data.
+ * \param stego Altered image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param levels Number of decomposition levels used during hiding.
+ * \param strengths Encoding intensities used during hiding, the original image is clamped the same way.
+ *
+ * \return Hidden data extracted form image, or an empty string if the sizes of the images differ.
+ */
+inline std::string decode_dwt_multi(const cv::Mat& img, const cv::Mat& stego, int channel = 0, int levels = 1, const cv::Vec3f& strengths = cv::Vec3f(0.1f, 0.1f, 0.1f))
+{
+	if (img.size() != stego.size())
+	{
+		return std::string();
+	}
+
+	auto haar1 = dwt_decompose_channel(img,   channel, levels, dwt_margin(levels, strengths));
+	auto haar2 = dwt_decompose_channel(stego, channel, levels);
+
+	return dwt_extract_subbands(dwt_detail_subbands(haar2, levels, strengths), dwt_detail_subbands(haar1, levels, strengths), 0, INT64_MAX);
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover data encapsulated with `encode_tlv` and hidden with
+ * `encode_dwt_multi`. The images are transformed once, and only the coefficients of the header and
+ * the payload are read.
+ *
+ * \param img Original image without hidden data.
+ * \param stego Altered image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param levels Number of decomposition levels used during hiding.
+ * \param strengths Encoding intensities used during hiding, the original image is clamped the same way.
+ *
+ * \return Hidden data extracted form image, or an empty string if the header is invalid.
+ */
+inline std::string decode_dwt_multi_tlv(const cv::Mat& img, const cv::Mat& stego, int channel = 0, int levels = 1, const cv::Vec3f& strengths = cv::Vec3f(0.1f, 0.1f, 0.1f))
+{
+	if (img.size() != stego.size())
+	{
+		return std::string();
+	}
+
+	auto haar1 = dwt_decompose_channel(img,   channel, levels, dwt_margin(levels, strengths));
+	auto haar2 = dwt_decompose_channel(stego, channel, levels);
+
+	auto bands1 = dwt_detail_subbands(haar1, levels, strengths);
+	auto bands2 = dwt_detail_subbands(haar2, levels, strengths);
+
+	return decode_tlv_lazy([&](int64_t offset, int64_t length) { return dwt_extract_subbands(bands2, bands1, offset, length); });
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover data hidden with `encode_dwt_multi_blind`.
+ *
+ * \param stego Altered image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param levels Number of decomposition levels used during hiding.
+ * \param strengths Encoding intensities used during hiding, only whether they are zero matters.
+ *
+ * \return Hidden data extracted form image.
+ */
+inline std::string decode_dwt_multi_blind(const cv::Mat& stego, int channel = 0, int levels = 1, const cv::Vec3f& strengths = cv::Vec3f(0.1f, 0.1f, 0.1f))
+{
+	auto haar = dwt_decompose_channel(stego, channel, levels);
+
+	return dwt_extract_subbands(dwt_detail_subbands(haar, levels, strengths), std::vector<cv::Mat>(), 0, INT64_MAX);
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover data encapsulated with `encode_tlv` and hidden with
+ * `encode_dwt_multi_blind`. The image is transformed once, and only the coefficients of the header and
+ * the payload are read.
+ *
+ * \param stego Altered image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param levels Number of decomposition levels used during hiding.
+ * \param strengths Encoding intensities used during hiding, only whether they are zero matters.
+ *
+ * \return Hidden data extracted form image, or an empty string if the header is invalid.
+ */
+inline std::string decode_dwt_multi_blind_tlv(const cv::Mat& stego, int channel = 0, int levels = 1, const cv::Vec3f& strengths = cv::Vec3f(0.1f, 0.1f, 0.1f))
+{
+	auto haar  = dwt_decompose_channel(stego, channel, levels);
+	auto bands = dwt_detail_subbands(haar, levels, strengths);
+
+	return decode_tlv_lazy([&](int64_t offset, int64_t length) { return dwt_extract_subbands(bands, std::vector<cv::Mat>(), offset, length); });
+}
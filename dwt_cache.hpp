@@ -0,0 +1,385 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <opencv2/core/core.hpp>
+#include "dwt.hpp"
+
+/*!
+ * Computes the 64-bit FNV-1a hash of a buffer, continuing from a previous hash.
+ *
+ * \param data Buffer to hash.
+ * \param size Size of the buffer in bytes.
+ * \param hash Hash of the preceding data.
+ *
+ * \return Hash of the data.
+ */
+inline uint64_t dwt_cache_hash(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	auto bytes = static_cast<const unsigned char*>(data);
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+/*!
+ * Derives the cache key of an image file from its contents.
+ * The file is hashed as is, without decoding the image.
+ *
+ * \param file Path to the image.
+ *
+ * \return Key of the image, or 0 if the file could not be read.
+ */
+inline uint64_t dwt_cache_key(const std::string& file)
+{
+	std::ifstream fs(file, std::ios::binary);
+
+	if (!fs)
+	{
+		return 0;
+	}
+
+	auto hash = dwt_cache_hash(nullptr, 0);
+	char buffer[65536];
+
+	while (fs.read(buffer, sizeof(buffer)) || fs.gcount() > 0)
+	{
+		hash = dwt_cache_hash(buffer, size_t(fs.gcount()), hash);
+	}
+
+	return hash;
+}
+
+/*!
+ * Derives the cache key of an image from its dimensions, type and pixels.
+ *
+ * \param img Input image.
+ *
+ * \return Key of the image.
+ */
+inline uint64_t dwt_cache_key(const cv::Mat& img)
+{
+	int header[] = { img.rows, img.cols, img.type() };
+
+	auto hash = dwt_cache_hash(header, sizeof(header));
+
+	for (int y = 0; y < img.rows; y++)
+	{
+		hash = dwt_cache_hash(img.ptr(y), img.cols * img.elemSize(), hash);
+	}
+
+	return hash;
+}
+
+/*!
+ * Caches the diagonal filter of original images, so repeated extractions
+ * with the same original only need to transform the altered image.
+ *
+ * Entries are identified by the content hash of the image and the channel,
+ * and the least recently used entries are evicted from memory. When a
+ * directory is specified, computed entries are also written there, and
+ * entries not in memory are memory-mapped from there, so they survive
+ * between runs and are shared between processes.
+ */
+class DwtCache
+{
+public:
+
+	/*!
+	 * Initializes a new instance of the cache.
+	 *
+	 * \param capacity Maximum number of entries kept in memory.
+	 * \param directory Directory to persist entries to, or empty to keep them in memory only.
+	 */
+	explicit DwtCache(size_t capacity = 8, const std::string& directory = "")
+		: capacity(capacity), directory(directory)
+	{
+	}
+
+	/*!
+	 * Returns the diagonal filter of a channel of an original image.
+	 *
+	 * \param key Key of the image, see `dwt_cache_key`.
+	 * \param channel Channel of the image.
+	 * \param load Function returning the decoded image, only called on a miss.
+	 *
+	 * \return Diagonal coefficients of the whole channel, or null if the image could not be loaded.
+	 */
+	std::shared_ptr<const cv::Mat> diagonal(uint64_t key, int channel, const std::function<cv::Mat()>& load)
+	{
+		auto id = std::make_pair(key, channel);
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+
+			auto it = index.find(id);
+
+			if (it != index.end())
+			{
+				entries.splice(entries.begin(), entries, it->second);
+				return it->second->second;
+			}
+		}
+
+		auto dds = map(key, channel);
+
+		if (!dds)
+		{
+			auto img = load();
+
+			if (!img.data || channel >= img.channels())
+			{
+				return nullptr;
+			}
+
+			// the rows are a view into the whole decomposition, which is not kept alive by the cache
+			dds = std::make_shared<const cv::Mat>(dwt_diagonal_rows(img, 0, img.rows / 2, channel).clone());
+
+			store(key, channel, *dds);
+		}
+
+		std::lock_guard<std::mutex> guard(lock);
+
+		auto it = index.find(id);
+
+		if (it != index.end())
+		{
+			entries.erase(it->second);
+		}
+
+		entries.emplace_front(id, dds);
+		index[id] = entries.begin();
+
+		while (entries.size() > capacity)
+		{
+			index.erase(entries.back().first);
+			entries.pop_back();
+		}
+
+		return dds;
+	}
+
+	/*!
+	 * Removes all entries from memory, persisted entries are kept.
+	 */
+	void clear()
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		entries.clear();
+		index.clear();
+	}
+
+private:
+
+	typedef std::pair<uint64_t, int> entry_id;
+	typedef std::list<std::pair<entry_id, std::shared_ptr<const cv::Mat>>> entry_list;
+
+	/*!
+	 * Memory-mapped persisted entry, owning the mapping its matrix points into.
+	 */
+	struct mapped_entry
+	{
+		boost::interprocess::file_mapping file;
+		boost::interprocess::mapped_region region;
+		cv::Mat dds;
+	};
+
+	/*!
+	 * Returns the path of the persisted entry.
+	 */
+	std::string path(uint64_t key, int channel) const
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.%d.dds", static_cast<unsigned long long>(key), channel);
+
+		return directory + "/" + name;
+	}
+
+	/*!
+	 * Maps a persisted entry into memory.
+	 *
+	 * \return Diagonal coefficients pointing into the mapping, or null if the entry is not persisted.
+	 */
+	std::shared_ptr<const cv::Mat> map(uint64_t key, int channel) const
+	{
+		using namespace boost::interprocess;
+
+		if (directory.empty())
+		{
+			return nullptr;
+		}
+
+		auto file = path(key, channel);
+
+		if (!std::ifstream(file))
+		{
+			return nullptr;
+		}
+
+		try
+		{
+			auto entry = std::make_shared<mapped_entry>();
+
+			entry->file   = file_mapping(file.c_str(), read_only);
+			entry->region = mapped_region(entry->file, read_only);
+
+			auto header = static_cast<const int32_t*>(entry->region.get_address());
+
+			if (entry->region.get_size() < sizeof(int32_t) * 2 || header[0] <= 0 || header[1] <= 0)
+			{
+				return nullptr;
+			}
+
+			// the number of values is compared, as the size in bytes could overflow for a corrupt header
+			auto values = entry->region.get_size() - sizeof(int32_t) * 2;
+
+			if (values % sizeof(float) != 0 || values / sizeof(float) != size_t(header[0]) * size_t(header[1]))
+			{
+				return nullptr;
+			}
+
+			entry->dds = cv::Mat(header[0], header[1], CV_32FC1, const_cast<int32_t*>(header + 2));
+
+			return std::shared_ptr<const cv::Mat>(entry, &entry->dds);
+		}
+		catch (const interprocess_exception&)
+		{
+			return nullptr;
+		}
+	}
+
+	/*!
+	 * Persists an entry, if a directory was specified.
+	 */
+	void store(uint64_t key, int channel, const cv::Mat& dds) const
+	{
+		if (directory.empty())
+		{
+			return;
+		}
+
+		auto file = path(key, channel);
+		auto temp = file + ".tmp";
+
+		{
+			std::ofstream fs(temp, std::ios::binary | std::ios::trunc);
+
+			int32_t header[] = { dds.rows, dds.cols };
+			fs.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+			for (int y = 0; y < dds.rows; y++)
+			{
+				fs.write(reinterpret_cast<const char*>(dds.ptr<float>(y)), dds.cols * sizeof(float));
+			}
+
+			if (!fs)
+			{
+				fs.close();
+				remove(temp.c_str());
+				return;
+			}
+		}
+
+		remove(file.c_str());
+
+		if (rename(temp.c_str(), file.c_str()) != 0)
+		{
+			remove(temp.c_str());
+		}
+	}
+
+	size_t capacity;
+	std::string directory;
+	std::mutex lock;
+	entry_list entries;
+	std::map<entry_id, entry_list::iterator> index;
+};
+
+/*!
+ * Returns the cache used by the extraction functions when none is specified.
+ *
+ * \return Process-wide cache kept in memory.
+ */
+inline DwtCache& dwt_default_cache()
+{
+	static DwtCache cache;
+	return cache;
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover a range of the data hidden in the diagonal filter of an image,
+ * taking the diagonal filter of the original image from a cache.
+ *
+ * \param cache Cache of original images.
+ * \param key Key of the original image, see `dwt_cache_key`.
+ * \param load Function returning the decoded original image, only called on a miss.
+ * \param stego Altered image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ * \param channel Channel to manipulate.
+ * \param order_key Key of the order in which the coefficients were visited, or an empty string for raster order.
+ *
+ * \return Hidden data extracted form image, or an empty string if the original image could not be loaded.
+ */
+inline std::string decode_dwt_cached_range(DwtCache& cache, uint64_t key, const std::function<cv::Mat()>& load, const cv::Mat& stego, int64_t offset, int64_t length, int channel = 0, const std::string& order_key = "")
+{
+	auto dds = cache.diagonal(key, channel, load);
+
+	if (!dds || dds->rows != stego.rows / 2 || dds->cols != stego.cols / 2)
+	{
+		return std::string();
+	}
+
+	return dwt_decode_range(stego, offset, length, channel, [&](int top, int rows) { return dds->rowRange(top, top + rows); }, Permutation(uint64_t(stego.cols / 2) * (stego.rows / 2), order_key));
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover data hidden in the diagonal filter of an image,
+ * taking the diagonal filter of the original image from a cache.
+ *
+ * \param cache Cache of original images.
+ * \param key Key of the original image, see `dwt_cache_key`.
+ * \param load Function returning the decoded original image, only called on a miss.
+ * \param stego Altered image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param order_key Key of the order in which the coefficients were visited, or an empty string for raster order.
+ *
+ * \return Hidden data extracted form image, or an empty string if the original image could not be loaded.
+ */
+inline std::string decode_dwt_cached(DwtCache& cache, uint64_t key, const std::function<cv::Mat()>& load, const cv::Mat& stego, int channel = 0, const std::string& order_key = "")
+{
+	return decode_dwt_cached_range(cache, key, load, stego, 0, int64_t(stego.cols / 2) * (stego.rows / 2) / 8, channel, order_key);
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover data encapsulated with `encode_tlv`,
+ * taking the diagonal filter of the original image from a cache.
+ *
+ * \param cache Cache of original images.
+ * \param key Key of the original image, see `dwt_cache_key`.
+ * \param load Function returning the decoded original image, only called on a miss.
+ * \param stego Altered image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param order_key Key of the order in which the coefficients were visited, or an empty string for raster order.
+ *
+ * \return Hidden data extracted form image, or an empty string if the header is invalid.
+ */
+inline std::string decode_dwt_cached_tlv(DwtCache& cache, uint64_t key, const std::function<cv::Mat()>& load, const cv::Mat& stego, int channel = 0, const std::string& order_key = "")
+{
+	return decode_tlv_lazy([&](int64_t offset, int64_t length) { return decode_dwt_cached_range(cache, key, load, stego, offset, length, channel, order_key); });
+}
@@ -82,7 +82,7 @@ inline std::string repair(const std::vector<std::string>& texts)
 }
 
 /*!
- * Reads the specified file into a string.
+ * Reads the specified file into a string, in binary mode, so the contents are kept intact.
  *
  * \param file Path to the file.
  *
@@ -90,7 +90,7 @@ inline std::string repair(const std::vector<std::string>& texts)
  */
 inline std::string read_file(const std::string& file)
 {
-	std::ifstream fs(file);
+	std::ifstream fs(file, std::ios::binary);
 	std::string text((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
 	fs.close();
 	return text;
@@ -1,101 +1,333 @@
 #pragma once
+#include <ostream>
+#include <vector>
 #include <opencv2/core/core.hpp>
 #include "helpers.hpp"
+#include "lsb_kernel.hpp"
+#include "tlv.hpp"
 
 /*!
- * Hides data in an image by manipulating the least significant bits of each pixel.
+ * Determines whether data can be hidden in an image with the number of bits per sample.
+ * Any 8-bit image is supported with one bit in raster order, other cases go through
+ * `LsbEngine`, which only handles 1, 3 or 4 channels.
  *
  * \param img Input image.
- * \param text Text to hide.
- * \param mode Storage mode, see STORE_* constants.
+ * \param bits Number of bits altered per sample.
+ * \param key Key of the order in which the samples are visited, or an empty string for raster order.
+ *
+ * \return Value indicating whether the type of the image, the number of bits and the order are supported.
+ */
+inline bool lsb_supported(const cv::Mat& img, int bits = 1, const std::string& key = "")
+{
+	return (img.depth() == CV_8U && bits == 1 && key.empty()) || lsb_dispatch(img.type(), bits, [](auto) {});
+}
+
+/*!
+ * Hides data in the least significant bits of each sample, reading from one image and writing to another.
+ * With one bit per 8-bit sample in raster order, the samples are altered row by row with `lsb_embed_bits`,
+ * or in a single run if the images are continuous, otherwise `LsbEngine` is used.
  *
- * \return Altered image with hidden data.
+ * \param src Input image.
+ * \param dst Output image of the same size and type, may be the same as `src`.
+ * \param payload Payload to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param bits Number of bits altered per sample.
+ * \param key Key of the order in which the samples are visited, or an empty string for raster order.
  */
-inline cv::Mat encode_lsb(const cv::Mat& img, const std::string& text, int mode = STORE_ONCE)
+inline void lsb_embed_rows(const cv::Mat& src, cv::Mat& dst, const Payload& payload, int mode, int bits = 1, const std::string& key = "")
 {
 	using namespace cv;
 	using namespace std;
 
-	int b = 0;
-	int bits = text.length() * 8 + 7;
+	// the terminating null character is hidden as well
+	auto size = (payload.size() + 1) * 8;
 
-	Mat stego;
-	img.copyTo(stego);
+	if (src.depth() != CV_8U || bits != 1 || !key.empty())
+	{
+		Permutation order(uint64_t(src.total()) * src.channels(), key);
+
+		lsb_dispatch(src.type(), bits, [&](auto engine) { engine.embed(src, dst, payload, size, mode, order); });
+		return;
+	}
 
-	for (int i = 0; i < img.rows; i++)
+	auto stride  = int64_t(src.cols) * src.channels();
+	auto rows    = src.rows;
+
+	if (src.isContinuous() && dst.isContinuous())
 	{
-		for (int j = 0; j < img.cols; j++)
-		{
-			for (int k = 0; k < img.channels(); k++)
-			{
-				auto val = img.at<Vec3b>(i, j)[k];
-
-				val &= 254;
-
-				if (b < bits)
-				{
-					val |= (text[b / 8] & 1 << b % 8) >> b % 8;
-				}
-
-				stego.at<Vec3b>(i, j)[k] = val;
-
-				if (b++ >= bits)
-				{
-					if (mode == STORE_ONCE)
-					{
-						break;
-					}
-					else if (mode == STORE_REPEAT)
-					{
-						b = 0;
-					}
-				}
-			}
-
-			if (b >= bits && mode == STORE_ONCE)
-			{
-				break;
-			}
-		}
+		stride *= rows;
+		rows    = 1;
+	}
 
-		if (b >= bits && mode == STORE_ONCE)
+	for (int y = 0; y < rows; y++)
+	{
+		auto in  = src.ptr<uchar>(y);
+		auto out = dst.ptr<uchar>(y);
+
+		auto more = lsb_embed_run(y * stride, stride, size, mode,
+			[&](int64_t offset, int64_t first, int64_t count) { lsb_embed_payload(in + offset, out + offset, payload, first, count); },
+			[&](int64_t offset, int64_t count) { lsb_clear_bits(in + offset, out + offset, count); });
+
+		if (!more)
 		{
 			break;
 		}
 	}
+}
+
+/*!
+ * Hides text in the least significant bits of each sample, reading from one image and writing to another.
+ *
+ * \param src Input image.
+ * \param dst Output image of the same size and type, may be the same as `src`.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param bits Number of bits altered per sample.
+ * \param key Key of the order in which the samples are visited, or an empty string for raster order.
+ */
+inline void lsb_embed_rows(const cv::Mat& src, cv::Mat& dst, const std::string& text, int mode, int bits = 1, const std::string& key = "")
+{
+	lsb_embed_rows(src, dst, Payload().append(text.data(), int64_t(text.length())), mode, bits, key);
+}
+
+/*!
+ * Hides data in an image by manipulating the least significant bits of each pixel.
+ *
+ * \param img Input image, with 8-bit or 16-bit samples if more than one bit is altered.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param bits Number of bits altered per sample, 1 to 4.
+ * \param key Key of the pseudo-random order in which the samples are visited, or an empty string for raster order.
+ *
+ * \return Altered image with hidden data, or an empty image if the image type is not supported.
+ */
+inline cv::Mat encode_lsb(const cv::Mat& img, const std::string& text, int mode = STORE_ONCE, int bits = 1, const std::string& key = "")
+{
+	if (!lsb_supported(img, bits, key))
+	{
+		return cv::Mat();
+	}
+
+	cv::Mat stego;
+	img.copyTo(stego);
+
+	lsb_embed_rows(img, stego, text, mode, bits, key);
 
 	return stego;
 }
 
 /*!
- * Recovers data hidden in an image using least significant bit manipulation.
+ * Hides data in an image by manipulating the least significant bits of each pixel,
+ * altering the pixels of the specified image instead of a copy.
+ *
+ * \param img Image to alter.
+ * \param payload Payload to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param bits Number of bits altered per sample, 1 to 4.
+ * \param key Key of the pseudo-random order in which the samples are visited, or an empty string for raster order.
+ *
+ * \return Number of leading rows altered, or -1 if the image type is not supported.
+ */
+inline int encode_lsb_inplace(cv::Mat& img, const Payload& payload, int mode = STORE_ONCE, int bits = 1, const std::string& key = "")
+{
+	if (!lsb_supported(img, bits, key))
+	{
+		return -1;
+	}
+
+	lsb_embed_rows(img, img, payload, mode, bits, key);
+
+	// the payload is scattered over the whole image in a keyed order
+	if (!key.empty())
+	{
+		return img.rows;
+	}
+
+	return lsb_altered_rows(img.rows, int64_t(img.cols) * img.channels() * bits, (payload.size() + 1) * 8, mode);
+}
+
+/*!
+ * Hides data in an image by manipulating the least significant bits of each pixel,
+ * altering the pixels of the specified image instead of a copy.
+ *
+ * \param img Image to alter.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param bits Number of bits altered per sample, 1 to 4.
+ * \param key Key of the pseudo-random order in which the samples are visited, or an empty string for raster order.
+ *
+ * \return Number of leading rows altered, or -1 if the image type is not supported.
+ */
+inline int encode_lsb_inplace(cv::Mat& img, const std::string& text, int mode = STORE_ONCE, int bits = 1, const std::string& key = "")
+{
+	return encode_lsb_inplace(img, Payload().append(text.data(), int64_t(text.length())), mode, bits, key);
+}
+
+/*!
+ * Hides data in an image by manipulating the least significant bits of each pixel,
+ * copying only the leading rows which carry the payload.
+ *
+ * \param img Input image.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param bits Number of bits altered per sample, 1 to 4.
+ * \param key Key of the pseudo-random order in which the samples are visited, or an empty string for raster order.
+ *
+ * \return Altered image sharing its unchanged rows with the input image, or an empty patch if the image type is not supported.
+ */
+inline LsbPatch encode_lsb_cow(const cv::Mat& img, const std::string& text, int mode = STORE_ONCE, int bits = 1, const std::string& key = "")
+{
+	LsbPatch patch;
+
+	if (!lsb_supported(img, bits, key))
+	{
+		return patch;
+	}
+
+	// the payload is scattered over the whole image in a keyed order
+	auto rows = key.empty() ? lsb_altered_rows(img.rows, int64_t(img.cols) * img.channels() * bits, (int64_t(text.length()) + 1) * 8, mode) : img.rows;
+
+	patch.image = img;
+	img.rowRange(0, rows).copyTo(patch.rows);
+
+	lsb_embed_rows(img.rowRange(0, rows), patch.rows, text, mode, bits, key);
+
+	return patch;
+}
+
+/*!
+ * Recovers a range of the data hidden in an image using least significant bit manipulation.
+ * Only the pixels carrying the requested bytes are read.
  *
  * \param img Input image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ * \param bits Number of bits altered per sample, 1 to 4.
+ * \param key Key of the order in which the samples were visited, or an empty string for raster order.
  *
- * \return Hidden data extracted form image.
+ * \return Hidden data extracted form image, shorter than requested if the image is too small,
+ *         or an empty string if the image type is not supported.
  */
-inline std::string decode_lsb(const cv::Mat& img)
+inline std::string decode_lsb_range(const cv::Mat& img, int64_t offset, int64_t length, int bits = 1, const std::string& key = "")
 {
 	using namespace cv;
 	using namespace std;
 
-	auto b = 0;
-	string text(img.cols * img.rows * img.channels() / 8, 0);
+	if (!lsb_supported(img, bits, key))
+	{
+		return string();
+	}
+
+	auto stride   = int64_t(img.cols) * img.channels();
+	auto capacity = stride * img.rows * bits / 8;
 
-	for (int i = 0; i < img.rows; i++)
+	string text(size_t(max(int64_t(0), min(length, capacity - offset))), 0);
+
+	auto first = offset * 8;
+	auto last  = first + int64_t(text.length()) * 8;
+
+	if (img.depth() != CV_8U || bits != 1 || !key.empty())
 	{
-		for (int j = 0; j < img.cols; j++)
+		if (first < last)
 		{
-			for (int k = 0; k < img.channels(); k++)
-			{
-				auto val = img.at<Vec3b>(i, j)[k];
-
-				text[b / 8] |= (val & 1) << b % 8;
+			Permutation order(uint64_t(img.total()) * img.channels(), key);
 
-				b++;
-			}
+			lsb_dispatch(img.type(), bits, [&](auto engine) { engine.extract(img, reinterpret_cast<uchar*>(&text[0]), first, last, order); });
 		}
+
+		return text;
+	}
+
+	for (auto b = first; b < last;)
+	{
+		auto y = int(b / stride);
+		auto x = b % stride;
+		auto n = min(last - b, img.isContinuous() ? last - b : stride - x);
+
+		lsb_extract_bits(img.ptr<uchar>(y) + x, reinterpret_cast<uchar*>(&text[0]), b - first, n);
+
+		b += n;
 	}
 
 	return text;
 }
+
+/*!
+ * Recovers data hidden in an image using least significant bit manipulation.
+ *
+ * \param img Input image with hidden data.
+ * \param bits Number of bits altered per sample, 1 to 4.
+ * \param key Key of the order in which the samples were visited, or an empty string for raster order.
+ *
+ * \return Hidden data extracted form image.
+ */
+inline std::string decode_lsb(const cv::Mat& img, int bits = 1, const std::string& key = "")
+{
+	return decode_lsb_range(img, 0, int64_t(img.cols) * img.rows * img.channels() * bits / 8, bits, key);
+}
+
+/*!
+ * Recovers data encapsulated with `encode_tlv` and hidden using least significant bit manipulation.
+ * The header is extracted first, and only the pixels covered by the payload are read afterwards.
+ *
+ * \param img Input image with hidden data.
+ * \param bits Number of bits altered per sample, 1 to 4.
+ * \param key Key of the order in which the samples were visited, or an empty string for raster order.
+ *
+ * \return Hidden data extracted form image, or an empty string if the header is invalid.
+ */
+inline std::string decode_lsb_tlv(const cv::Mat& img, int bits = 1, const std::string& key = "")
+{
+	return decode_tlv_lazy([&](int64_t offset, int64_t length) { return decode_lsb_range(img, offset, length, bits, key); });
+}
+
+/*!
+ * Recovers a range of the data hidden in an image using least significant bit manipulation,
+ * writing it to a stream in chunks instead of returning it as a single string.
+ *
+ * \param img Input image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ * \param out Stream to write the extracted data to.
+ * \param bits Number of bits altered per sample, 1 to 4.
+ * \param key Key of the order in which the samples were visited, or an empty string for raster order.
+ *
+ * \return Number of bytes written, fewer than requested if the image is too small.
+ */
+inline int64_t decode_lsb_range_to(const cv::Mat& img, int64_t offset, int64_t length, std::ostream& out, int bits = 1, const std::string& key = "")
+{
+	using namespace std;
+
+	auto written = int64_t(0);
+
+	while (written < length && out)
+	{
+		auto chunk = decode_lsb_range(img, offset + written, min(length - written, PAYLOAD_CHUNK_SIZE), bits, key);
+
+		if (chunk.empty())
+		{
+			break;
+		}
+
+		out.write(chunk.data(), chunk.length());
+		written += chunk.length();
+	}
+
+	return written;
+}
+
+/*!
+ * Recovers data encapsulated with `encode_tlv` and hidden using least significant bit manipulation,
+ * writing it to a stream in chunks, so binary data is kept intact.
+ *
+ * \param img Input image with hidden data.
+ * \param out Stream to write the extracted data to.
+ * \param bits Number of bits altered per sample, 1 to 4.
+ * \param key Key of the order in which the samples were visited, or an empty string for raster order.
+ *
+ * \return Number of bytes written, or -1 if the header is invalid.
+ */
+inline int64_t decode_lsb_tlv_to(const cv::Mat& img, std::ostream& out, int bits = 1, const std::string& key = "")
+{
+	return decode_tlv_stream([&](int64_t offset, int64_t length, std::ostream& stream) { return decode_lsb_range_to(img, offset, length, stream, bits, key); }, out);
+}
@@ -1,92 +1,262 @@
 #pragma once
 #include <opencv2/core/core.hpp>
+#include "lsb_kernel.hpp"
+#include "tlv.hpp"
 
 /*!
- * Hides data in an image by manipulating the least significant bits of each pixel.
- * This version does not utilize all the channels and sequentially hops between them.
+ * Hides data in the least significant bit of one channel of each pixel, hopping between the channels,
+ * reading from one image and writing to another.
+ * The pixels are altered row by row with `lsb_alt_embed_bits`, or in a single run if the images are continuous.
+ * With a key, the pixels are visited in a keyed order instead, and each pixel still uses the channel
+ * given by its position within the image, so the extraction does not depend on the order.
  *
- * \param img Input image.
- * \param text Text to hide.
+ * \param src Input image.
+ * \param dst Output image of the same size and type, may be the same as `src`.
+ * \param payload Payload to hide.
  * \param mode Storage mode, see STORE_* constants.
- *
- * \return Altered image with hidden data.
+ * \param key Key of the order in which the pixels are visited, or an empty string for raster order.
  */
-inline cv::Mat encode_lsb_alt(const cv::Mat& img, const std::string& text, int mode = STORE_ONCE)
+inline void lsb_alt_embed_rows(const cv::Mat& src, cv::Mat& dst, const Payload& payload, int mode, const std::string& key = "")
 {
 	using namespace cv;
 	using namespace std;
 
-	int c = 0;
-	int b = 0;
-	int bits = text.length() * 8 + 7;
+	// the terminating null character is hidden as well
+	auto size = (payload.size() + 1) * 8;
 
-	Mat stego;
-	img.copyTo(stego);
+	auto channels = src.channels();
 
-	for (int i = 0; i < img.rows; i++)
+	if (!key.empty())
 	{
-		for (int j = 0; j < img.cols; j++)
+		LsbPayloadReader bits(payload);
+		Permutation order(uint64_t(src.total()), key);
+
+		auto total = int64_t(src.total());
+		auto count = mode == STORE_ONCE ? min(size, total) : total;
+
+		for (int64_t i = 0; i < count; i++)
 		{
-			auto val = img.at<Vec3b>(i, j)[c % img.channels()];
-
-			val &= 254;
-
-			if (b < bits)
-			{
-				val |= (text[b / 8] & 1 << b % 8) >> b % 8;
-			}
-
-			stego.at<Vec3b>(i, j)[c++ % img.channels()] = val;
-
-			if (b++ >= bits)
-			{
-				if (mode == STORE_ONCE)
-				{
-					break;
-				}
-				else if (mode == STORE_REPEAT)
-				{
-					b = 0;
-				}
-			}
+			auto p = int64_t(order(uint64_t(i)));
+			auto y = int(p / src.cols);
+			auto x = (p % src.cols) * channels + p % channels;
+			auto b = mode == STORE_REPEAT ? i % size : i;
+
+			dst.ptr<uchar>(y)[x] = uchar((src.ptr<uchar>(y)[x] & 254) | (b < size ? bits(b, 1) : 0));
 		}
 
-		if (b >= bits && mode == STORE_ONCE)
+		return;
+	}
+
+	auto stride   = int64_t(src.cols);
+	auto rows     = src.rows;
+
+	if (src.isContinuous() && dst.isContinuous())
+	{
+		stride *= rows;
+		rows    = 1;
+	}
+
+	for (int y = 0; y < rows; y++)
+	{
+		auto in    = src.ptr<uchar>(y);
+		auto out   = dst.ptr<uchar>(y);
+		auto index = y * stride;
+
+		auto more = lsb_embed_run(index, stride, size, mode,
+			[&](int64_t offset, int64_t first, int64_t count) { lsb_alt_embed_payload(in + offset * channels, out + offset * channels, channels, int((index + offset) % channels), payload, first, count); },
+			[&](int64_t offset, int64_t count) { lsb_alt_embed_bits(in + offset * channels, out + offset * channels, channels, int((index + offset) % channels), nullptr, 0, count, true); });
+
+		if (!more)
 		{
 			break;
 		}
 	}
+}
+
+/*!
+ * Hides text in the least significant bit of one channel of each pixel, hopping between the channels,
+ * reading from one image and writing to another.
+ *
+ * \param src Input image.
+ * \param dst Output image of the same size and type, may be the same as `src`.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param key Key of the order in which the pixels are visited, or an empty string for raster order.
+ */
+inline void lsb_alt_embed_rows(const cv::Mat& src, cv::Mat& dst, const std::string& text, int mode, const std::string& key = "")
+{
+	lsb_alt_embed_rows(src, dst, Payload().append(text.data(), int64_t(text.length())), mode, key);
+}
+
+/*!
+ * Hides data in an image by manipulating the least significant bits of each pixel.
+ * This version does not utilize all the channels and sequentially hops between them.
+ *
+ * \param img Input image.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param key Key of the pseudo-random order in which the pixels are visited, or an empty string for raster order.
+ *
+ * \return Altered image with hidden data.
+ */
+inline cv::Mat encode_lsb_alt(const cv::Mat& img, const std::string& text, int mode = STORE_ONCE, const std::string& key = "")
+{
+	cv::Mat stego;
+	img.copyTo(stego);
+
+	lsb_alt_embed_rows(img, stego, text, mode, key);
 
 	return stego;
 }
 
 /*!
- * Recovers data hidden in an image using least significant bit manipulation.
+ * Hides data in an image by manipulating the least significant bits of each pixel,
+ * altering the pixels of the specified image instead of a copy.
+ * This version does not utilize all the channels and sequentially hops between them.
+ *
+ * \param img Image to alter.
+ * \param payload Payload to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param key Key of the pseudo-random order in which the pixels are visited, or an empty string for raster order.
+ *
+ * \return Number of leading rows altered.
+ */
+inline int encode_lsb_alt_inplace(cv::Mat& img, const Payload& payload, int mode = STORE_ONCE, const std::string& key = "")
+{
+	lsb_alt_embed_rows(img, img, payload, mode, key);
+
+	// the payload is scattered over the whole image in a keyed order
+	if (!key.empty())
+	{
+		return img.rows;
+	}
+
+	return lsb_altered_rows(img.rows, img.cols, (payload.size() + 1) * 8, mode);
+}
+
+/*!
+ * Hides text in an image by manipulating the least significant bits of each pixel,
+ * altering the pixels of the specified image instead of a copy.
  * This version does not utilize all the channels and sequentially hops between them.
  *
+ * \param img Image to alter.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param key Key of the pseudo-random order in which the pixels are visited, or an empty string for raster order.
+ *
+ * \return Number of leading rows altered.
+ */
+inline int encode_lsb_alt_inplace(cv::Mat& img, const std::string& text, int mode = STORE_ONCE, const std::string& key = "")
+{
+	return encode_lsb_alt_inplace(img, Payload().append(text.data(), int64_t(text.length())), mode, key);
+}
+
+/*!
+ * Hides data in an image by manipulating the least significant bits of each pixel,
+ * copying only the leading rows which carry the payload.
+ * This version does not utilize all the channels and sequentially hops between them.
+ *
+ * \param img Input image.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param key Key of the pseudo-random order in which the pixels are visited, or an empty string for raster order.
+ *
+ * \return Altered image sharing its unchanged rows with the input image.
+ */
+inline LsbPatch encode_lsb_alt_cow(const cv::Mat& img, const std::string& text, int mode = STORE_ONCE, const std::string& key = "")
+{
+	// the payload is scattered over the whole image in a keyed order
+	auto rows = key.empty() ? lsb_altered_rows(img.rows, img.cols, (int64_t(text.length()) + 1) * 8, mode) : img.rows;
+
+	LsbPatch patch;
+	patch.image = img;
+	img.rowRange(0, rows).copyTo(patch.rows);
+
+	lsb_alt_embed_rows(img.rowRange(0, rows), patch.rows, text, mode, key);
+
+	return patch;
+}
+
+/*!
+ * Recovers a range of the data hidden in an image using least significant bit manipulation.
+ * This version does not utilize all the channels and sequentially hops between them.
+ * Only the pixels carrying the requested bytes are read.
+ *
  * \param img Input image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ * \param key Key of the order in which the pixels were visited, or an empty string for raster order.
  *
- * \return Hidden data extracted form image.
+ * \return Hidden data extracted form image, shorter than requested if the image is too small.
  */
-inline std::string decode_lsb_alt(const cv::Mat& img)
+inline std::string decode_lsb_alt_range(const cv::Mat& img, int64_t offset, int64_t length, const std::string& key = "")
 {
 	using namespace cv;
 	using namespace std;
 
-	auto b = 0;
-	string text(img.cols * img.rows * img.channels() / 8, 0);
+	auto pixels   = int64_t(img.cols) * img.rows;
+	auto capacity = pixels * img.channels() / 8;
 
-	for (int i = 0; i < img.rows; i++)
+	string text(size_t(max(int64_t(0), min(length, capacity - offset))), 0);
+
+	auto first = offset * 8;
+	auto last  = min(first + int64_t(text.length()) * 8, pixels);
+
+	if (!key.empty())
 	{
-		for (int j = 0; j < img.cols; j++)
-		{
-			auto val = img.at<Vec3b>(i, j)[b % img.channels()];
+		Permutation order(uint64_t(pixels), key);
 
-			text[b / 8] |= (val & 1) << b % 8;
+		for (auto b = first; b < last; b++)
+		{
+			auto p = int64_t(order(uint64_t(b)));
+			auto y = int(p / img.cols);
+			auto x = (p % img.cols) * img.channels() + p % img.channels();
 
-			b++;
+			text[size_t((b - first) / 8)] |= (img.ptr<uchar>(y)[x] & 1) << ((b - first) % 8);
 		}
+
+		return text;
+	}
+
+	for (auto b = first; b < last;)
+	{
+		auto y = int(b / img.cols);
+		auto x = b % img.cols;
+		auto n = min(last - b, img.isContinuous() ? last - b : img.cols - x);
+
+		lsb_alt_extract_bits(img.ptr<uchar>(y) + x * img.channels(), img.channels(), int(b % img.channels()), reinterpret_cast<uchar*>(&text[0]), b - first, n);
+
+		b += n;
 	}
 
 	return text;
 }
+
+/*!
+ * Recovers data hidden in an image using least significant bit manipulation.
+ * This version does not utilize all the channels and sequentially hops between them.
+ *
+ * \param img Input image with hidden data.
+ * \param key Key of the order in which the pixels were visited, or an empty string for raster order.
+ *
+ * \return Hidden data extracted form image.
+ */
+inline std::string decode_lsb_alt(const cv::Mat& img, const std::string& key = "")
+{
+	return decode_lsb_alt_range(img, 0, int64_t(img.cols) * img.rows * img.channels() / 8, key);
+}
+
+/*!
+ * Recovers data encapsulated with `encode_tlv` and hidden using least significant bit manipulation.
+ * This version does not utilize all the channels and sequentially hops between them.
+ * The header is extracted first, and only the pixels covered by the payload are read afterwards.
+ *
+ * \param img Input image with hidden data.
+ * \param key Key of the order in which the pixels were visited, or an empty string for raster order.
+ *
+ * \return Hidden data extracted form image, or an empty string if the header is invalid.
+ */
+inline std::string decode_lsb_alt_tlv(const cv::Mat& img, const std::string& key = "")
+{
+	return decode_tlv_lazy([&](int64_t offset, int64_t length) { return decode_lsb_alt_range(img, offset, length, key); });
+}
@@ -0,0 +1,809 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "helpers.hpp"
+#include "payload.hpp"
+#include "permutation.hpp"
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define LSB_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define LSB_SSE2 1
+#endif
+
+/*!
+ * Replaces the least significant bits of a run of samples with bits of a payload.
+ *
+ * Once the position within the payload is aligned to a byte, each payload
+ * byte is broadcast to eight lanes and tested against a per-lane bit mask,
+ * so 16 (SSE2) or 32 (AVX2) samples are altered with a few instructions and
+ * without any per-bit divisions.
+ *
+ * \param src Source samples.
+ * \param dst Destination samples, may be the same as `src`.
+ * \param bits Payload, with the bits of each byte in ascending order.
+ * \param first Index of the payload bit hidden in the first sample.
+ * \param count Number of samples.
+ */
+inline void lsb_embed_bits(const unsigned char* src, unsigned char* dst, const unsigned char* bits, int64_t first, int64_t count)
+{
+	auto i = int64_t(0);
+
+	for (; i < count && (first + i) % 8 != 0; i++)
+	{
+		dst[i] = (src[i] & 254) | (bits[(first + i) / 8] >> (first + i) % 8 & 1);
+	}
+
+	auto payload = bits + (first + i) / 8;
+
+#if LSB_AVX2
+
+	auto select8 = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+	auto mask8   = _mm256_set1_epi64x(0x8040201008040201ll);
+	auto one8    = _mm256_set1_epi8(1);
+	auto clear8  = _mm256_set1_epi8(char(254));
+
+	for (; i + 32 <= count; i += 32, payload += 4)
+	{
+		int32_t word;
+		memcpy(&word, payload, sizeof(word));
+
+		auto spread = _mm256_shuffle_epi8(_mm256_set1_epi32(word), select8);
+		auto values = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(spread, mask8), mask8), one8);
+		auto pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(_mm256_and_si256(pixels, clear8), values));
+	}
+
+#endif
+#if LSB_SSE2
+
+	auto mask4  = _mm_set1_epi64x(0x8040201008040201ll);
+	auto one4   = _mm_set1_epi8(1);
+	auto clear4 = _mm_set1_epi8(char(254));
+
+	for (; i + 16 <= count; i += 16, payload += 2)
+	{
+		auto spread = _mm_cvtsi32_si128(payload[0] | payload[1] << 8);
+
+		spread = _mm_unpacklo_epi8(spread, spread);
+		spread = _mm_unpacklo_epi16(spread, spread);
+		spread = _mm_unpacklo_epi32(spread, spread);
+
+		auto values = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(spread, mask4), mask4), one4);
+		auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_and_si128(pixels, clear4), values));
+	}
+
+#endif
+
+	for (; i < count; i++)
+	{
+		dst[i] = (src[i] & 254) | (bits[(first + i) / 8] >> (first + i) % 8 & 1);
+	}
+}
+
+/*!
+ * Clears the least significant bits of a run of samples.
+ *
+ * \param src Source samples.
+ * \param dst Destination samples, may be the same as `src`.
+ * \param count Number of samples.
+ */
+inline void lsb_clear_bits(const unsigned char* src, unsigned char* dst, int64_t count)
+{
+	auto i = int64_t(0);
+
+#if LSB_AVX2
+
+	auto clear8 = _mm256_set1_epi8(char(254));
+
+	for (; i + 32 <= count; i += 32)
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), clear8));
+	}
+
+#endif
+#if LSB_SSE2
+
+	auto clear4 = _mm_set1_epi8(char(254));
+
+	for (; i + 16 <= count; i += 16)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), clear4));
+	}
+
+#endif
+
+	for (; i < count; i++)
+	{
+		dst[i] = src[i] & 254;
+	}
+}
+
+/*!
+ * Collects the least significant bits of a run of samples into a payload.
+ *
+ * Once the position within the payload is aligned to a byte, the bits are
+ * shifted into the sign bit of each lane and packed with `movemask`, which
+ * yields the payload bytes of 16 (SSE2) or 32 (AVX2) samples directly.
+ *
+ * \param src Source samples.
+ * \param bits Payload, the bytes covered have to be cleared beforehand.
+ * \param first Index of the payload bit stored in the first sample.
+ * \param count Number of samples.
+ */
+inline void lsb_extract_bits(const unsigned char* src, unsigned char* bits, int64_t first, int64_t count)
+{
+	auto i = int64_t(0);
+
+	for (; i < count && (first + i) % 8 != 0; i++)
+	{
+		bits[(first + i) / 8] |= (src[i] & 1) << (first + i) % 8;
+	}
+
+	auto payload = bits + (first + i) / 8;
+
+#if LSB_AVX2
+
+	for (; i + 32 <= count; i += 32, payload += 4)
+	{
+		auto word = int32_t(_mm256_movemask_epi8(_mm256_slli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), 7)));
+		memcpy(payload, &word, sizeof(word));
+	}
+
+#endif
+#if LSB_SSE2
+
+	for (; i + 16 <= count; i += 16, payload += 2)
+	{
+		auto word = uint16_t(_mm_movemask_epi8(_mm_slli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), 7)));
+		memcpy(payload, &word, sizeof(word));
+	}
+
+#endif
+
+	for (; i < count; i++)
+	{
+		bits[(first + i) / 8] |= (src[i] & 1) << (first + i) % 8;
+	}
+}
+
+/*!
+ * Replaces the least significant bits of a run of samples with bits of a payload made up
+ * of multiple segments, clearing the bits of the samples past the end of the payload.
+ *
+ * \param src Source samples.
+ * \param dst Destination samples, may be the same as `src`.
+ * \param payload Payload to hide.
+ * \param first Index of the payload bit hidden in the first sample.
+ * \param count Number of samples.
+ */
+inline void lsb_embed_payload(const unsigned char* src, unsigned char* dst, const Payload& payload, int64_t first, int64_t count)
+{
+	payload.split(first, count, [&](const unsigned char* bits, int64_t index, int64_t offset, int64_t n)
+	{
+		if (bits)
+		{
+			lsb_embed_bits(src + offset, dst + offset, bits, index, n);
+		}
+		else
+		{
+			lsb_clear_bits(src + offset, dst + offset, n);
+		}
+	}, 8);
+}
+
+/*!
+ * Collects the least significant bits of consecutive runs of samples into a buffer,
+ * which is written to a stream each time it fills up, so extracted data of any
+ * size is written in chunks of PAYLOAD_CHUNK_SIZE bytes.
+ */
+class LsbWriter
+{
+public:
+
+	/*!
+	 * Initializes a new instance of the writer.
+	 *
+	 * \param out Stream to write the extracted bytes to.
+	 * \param first Index of the first payload bit to extract, a multiple of 8.
+	 * \param last Index after the last payload bit to extract, a multiple of 8.
+	 */
+	LsbWriter(std::ostream& out, int64_t first, int64_t last)
+		: out(out), first(first), base(first), last(last), buffer(size_t(std::min(PAYLOAD_CHUNK_SIZE, (last - first) / 8)))
+	{
+	}
+
+	/*!
+	 * Collects the bits of a run of samples, which has to follow the previous run.
+	 *
+	 * \param src Source samples.
+	 * \param index Index of the payload bit stored in the first sample.
+	 * \param count Number of samples.
+	 *
+	 * \return Value indicating whether the stream is still writable.
+	 */
+	bool extract(const unsigned char* src, int64_t index, int64_t count)
+	{
+		while (count > 0)
+		{
+			auto end = std::min(last, base + int64_t(buffer.size()) * 8);
+			auto n   = std::min(count, end - index);
+
+			lsb_extract_bits(src, buffer.data(), index - base, n);
+
+			src   += n;
+			index += n;
+			count -= n;
+
+			if (index == end)
+			{
+				out.write(reinterpret_cast<const char*>(buffer.data()), (end - base) / 8);
+				memset(buffer.data(), 0, buffer.size());
+				base = end;
+			}
+		}
+
+		return bool(out);
+	}
+
+	/*!
+	 * Returns the number of bytes written so far.
+	 *
+	 * \return Number of bytes extracted and written to the stream.
+	 */
+	int64_t written() const
+	{
+		return (base - first) / 8;
+	}
+
+private:
+
+	std::ostream& out;
+	int64_t first;
+	int64_t base;
+	int64_t last;
+	std::vector<unsigned char> buffer;
+};
+
+/*!
+ * Replaces the least significant bits of one sample per pixel in a run of pixels,
+ * hopping to the next channel with each pixel, as done by `encode_lsb_alt`.
+ * The samples are not contiguous, so the run is walked with a pointer, which
+ * advances by one pixel and one channel, or wraps back to the first channel.
+ *
+ * \param src Source pixels.
+ * \param dst Destination pixels, may be the same as `src`.
+ * \param channels Number of channels per pixel.
+ * \param phase Channel used by the first pixel.
+ * \param bits Payload, with the bits of each byte in ascending order.
+ * \param first Index of the payload bit hidden in the first pixel.
+ * \param count Number of pixels.
+ * \param clear Clear the bits instead of hiding the payload.
+ */
+inline void lsb_alt_embed_bits(const unsigned char* src, unsigned char* dst, int channels, int phase, const unsigned char* bits, int64_t first, int64_t count, bool clear = false)
+{
+	auto offset  = int64_t(phase);
+	auto payload = bits + first / 8;
+	auto bit     = int(first % 8);
+
+	for (auto i = int64_t(0); i < count; i++)
+	{
+		auto val = clear ? 0 : *payload >> bit & 1;
+
+		dst[offset] = (src[offset] & 254) | val;
+
+		offset += channels + 1;
+
+		if (++phase == channels)
+		{
+			phase   = 0;
+			offset -= channels;
+		}
+
+		if (++bit == 8)
+		{
+			bit = 0;
+			payload++;
+		}
+	}
+}
+
+/*!
+ * Replaces the least significant bits of one sample per pixel in a run of pixels with bits
+ * of a payload made up of multiple segments, hopping to the next channel with each pixel,
+ * and clearing the bits of the pixels past the end of the payload.
+ *
+ * \param src Source pixels.
+ * \param dst Destination pixels, may be the same as `src`.
+ * \param channels Number of channels per pixel.
+ * \param phase Channel used by the first pixel.
+ * \param payload Payload to hide.
+ * \param first Index of the payload bit hidden in the first pixel.
+ * \param count Number of pixels.
+ */
+inline void lsb_alt_embed_payload(const unsigned char* src, unsigned char* dst, int channels, int phase, const Payload& payload, int64_t first, int64_t count)
+{
+	payload.split(first, count, [&](const unsigned char* bits, int64_t index, int64_t offset, int64_t n)
+	{
+		lsb_alt_embed_bits(src + offset * channels, dst + offset * channels, channels, int((phase + offset) % channels), bits, bits ? index : 0, n, !bits);
+	}, 8);
+}
+
+/*!
+ * Collects the least significant bits of one sample per pixel in a run of pixels,
+ * hopping to the next channel with each pixel, as done by `encode_lsb_alt`.
+ *
+ * \param src Source pixels.
+ * \param channels Number of channels per pixel.
+ * \param phase Channel used by the first pixel.
+ * \param bits Payload, the bytes covered have to be cleared beforehand.
+ * \param first Index of the payload bit stored in the first pixel.
+ * \param count Number of pixels.
+ */
+inline void lsb_alt_extract_bits(const unsigned char* src, int channels, int phase, unsigned char* bits, int64_t first, int64_t count)
+{
+	auto offset  = int64_t(phase);
+	auto payload = bits + first / 8;
+	auto bit     = int(first % 8);
+
+	for (auto i = int64_t(0); i < count; i++)
+	{
+		*payload |= (src[offset] & 1) << bit;
+
+		offset += channels + 1;
+
+		if (++phase == channels)
+		{
+			phase   = 0;
+			offset -= channels;
+		}
+
+		if (++bit == 8)
+		{
+			bit = 0;
+			payload++;
+		}
+	}
+}
+
+/*!
+ * Splits a run of samples into the parts which hide payload bits and the parts
+ * which are cleared, according to the storage mode. With STORE_REPEAT, the
+ * payload restarts after every `size` samples.
+ *
+ * \param index Index of the first sample of the run within the whole image.
+ * \param count Number of samples in the run.
+ * \param size Number of bits in the payload.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param embed Function hiding payload bits, receiving the offset within the run,
+ *              the index of the first payload bit, and the number of samples.
+ * \param clear Function clearing bits, receiving the offset within the run and
+ *              the number of samples.
+ *
+ * \return Value indicating whether further samples are to be altered.
+ */
+template<typename Embed, typename Clear>
+inline bool lsb_embed_run(int64_t index, int64_t count, int64_t size, int mode, Embed embed, Clear clear)
+{
+	using namespace std;
+
+	for (auto done = int64_t(0); done < count;)
+	{
+		auto position = index + done;
+
+		if (position >= size && mode == STORE_REPEAT && size > 0)
+		{
+			position %= size;
+		}
+
+		if (position < size)
+		{
+			auto n = min(count - done, size - position);
+
+			embed(done, position, n);
+			done += n;
+		}
+		else if (mode == STORE_ONCE)
+		{
+			return false;
+		}
+		else
+		{
+			clear(done, count - done);
+			done = count;
+		}
+	}
+
+	return mode != STORE_ONCE || index + count < size;
+}
+
+/*!
+ * Calculates the number of leading rows altered when hiding data with the storage mode.
+ * Only STORE_ONCE leaves the rows after the payload untouched.
+ *
+ * \param rows Number of rows in the image.
+ * \param stride Number of samples carrying a bit in each row.
+ * \param size Number of bits in the payload.
+ * \param mode Storage mode, see STORE_* constants.
+ *
+ * \return Number of rows altered.
+ */
+inline int lsb_altered_rows(int rows, int64_t stride, int64_t size, int mode)
+{
+	if (mode != STORE_ONCE || stride <= 0)
+	{
+		return rows;
+	}
+
+	return int(std::min(int64_t(rows), (size + stride - 1) / stride));
+}
+
+/*!
+ * Altered image which shares its unchanged rows with the original image.
+ * The leading rows carrying the payload are copied, the rest point into the original.
+ */
+struct LsbPatch
+{
+	/*!
+	 * Original image, shared with the caller.
+	 */
+	cv::Mat image;
+
+	/*!
+	 * Altered copy of the leading rows of the image.
+	 */
+	cv::Mat rows;
+
+	/*!
+	 * Returns a row of the altered image.
+	 *
+	 * \param y Index of the row.
+	 *
+	 * \return Row from the altered copy, or from the original image if it was not changed.
+	 */
+	cv::Mat row(int y) const
+	{
+		return y < rows.rows ? rows.row(y) : image.row(y);
+	}
+
+	/*!
+	 * Assembles the whole altered image.
+	 *
+	 * \return Copy of the original image with the altered rows applied.
+	 */
+	cv::Mat merge() const
+	{
+		cv::Mat stego;
+		image.copyTo(stego);
+
+		if (rows.rows > 0)
+		{
+			rows.copyTo(stego.rowRange(0, rows.rows));
+		}
+
+		return stego;
+	}
+};
+
+/*!
+ * Reads the bits of a payload through a window of bounded size, which is moved
+ * along as the bits are requested, so the payload is never copied as a whole.
+ * Bits past the end of the payload read as zeros.
+ */
+class LsbPayloadReader
+{
+public:
+
+	/*!
+	 * Initializes a new instance of the reader.
+	 *
+	 * \param payload Payload to read, which has to outlive the reader.
+	 */
+	explicit LsbPayloadReader(const Payload& payload)
+		: payload(payload), window(size_t(std::min(PAYLOAD_CHUNK_SIZE, payload.size() + 1) + 2)), first(-1)
+	{
+	}
+
+	/*!
+	 * Returns the bits of the payload starting at the specified bit.
+	 *
+	 * \param b Index of the first bit.
+	 * \param mask Mask of the bits to return, at most 9 bits wide.
+	 *
+	 * \return Bits of the payload in ascending order.
+	 */
+	int operator()(int64_t b, int mask)
+	{
+		auto byte = b >> 3;
+
+		// the window is reloaded when the two bytes covering the bits are not both within it
+		if (first < 0 || byte < first || byte + 2 > first + int64_t(window.size()))
+		{
+			first = byte;
+			payload.read(first, int64_t(window.size()), window.data());
+		}
+
+		auto i = size_t(byte - first);
+
+		return (window[i] | window[i + 1] << 8) >> (b & 7) & mask;
+	}
+
+private:
+
+	const Payload& payload;
+	std::vector<unsigned char> window;
+	int64_t first;
+};
+
+/*!
+ * Hides and recovers data in the least significant bits of each sample,
+ * instantiated for each supported pixel type and number of bits per sample,
+ * so the inner loops do not branch on the type of the image.
+ *
+ * The bits of the payload are stored in ascending order, the first payload bit
+ * in the lowest bit of the first sample, and each sample carries `Bits` payload bits.
+ *
+ * \tparam Pixel Type of a pixel, such as `uchar`, `cv::Vec3b` or `cv::Vec4w`.
+ * \tparam Bits Number of bits altered per sample, 1 to 4.
+ */
+template<typename Pixel, int Bits>
+class LsbEngine
+{
+	static_assert(Bits >= 1 && Bits <= 4, "Supported bits per sample are 1 to 4.");
+
+public:
+
+	/*!
+	 * Type of a single sample within a pixel.
+	 */
+	typedef typename cv::DataType<Pixel>::channel_type sample_type;
+
+	/*!
+	 * Number of samples within a pixel.
+	 */
+	static const int channels = cv::DataType<Pixel>::channels;
+
+	/*!
+	 * Mask of the bits altered within a sample.
+	 */
+	static const int mask = (1 << Bits) - 1;
+
+	/*!
+	 * Hides a payload in an image.
+	 *
+	 * \param src Input image.
+	 * \param dst Output image of the same size and type, may be the same as `src`.
+	 * \param payload Payload to hide, read through a window of bounded size.
+	 * \param size Number of bits to hide, the bits past the end of the payload are zeros.
+	 * \param mode Storage mode, see STORE_* constants.
+	 */
+	static void embed(const cv::Mat& src, cv::Mat& dst, const Payload& payload, int64_t size, int mode)
+	{
+		LsbPayloadReader bits(payload);
+
+		auto stride = int64_t(src.cols) * channels;
+		auto rows   = src.rows;
+
+		if (src.isContinuous() && dst.isContinuous())
+		{
+			stride *= rows;
+			rows    = 1;
+		}
+
+		auto b = int64_t(0);
+
+		for (int y = 0; y < rows; y++)
+		{
+			auto in  = src.ptr<sample_type>(y);
+			auto out = dst.ptr<sample_type>(y);
+
+			for (int64_t x = 0; x < stride; x++)
+			{
+				if (b >= size)
+				{
+					if (mode == STORE_ONCE)
+					{
+						return;
+					}
+					else if (mode == STORE_REPEAT)
+					{
+						b = 0;
+					}
+				}
+
+				auto val = in[x] & ~mask;
+
+				if (b < size)
+				{
+					val |= bits(b, mask);
+					b   += Bits;
+				}
+
+				out[x] = sample_type(val);
+			}
+		}
+	}
+
+	/*!
+	 * Recovers a range of the payload hidden in an image.
+	 *
+	 * \param img Input image with hidden data.
+	 * \param bits Payload, the bytes covered have to be cleared beforehand.
+	 * \param first Index of the first payload bit to recover, a multiple of 8.
+	 * \param last Index after the last payload bit to recover, a multiple of 8.
+	 */
+	static void extract(const cv::Mat& img, unsigned char* bits, int64_t first, int64_t last)
+	{
+		auto stride = int64_t(img.cols) * channels;
+		auto rows   = img.rows;
+
+		if (img.isContinuous())
+		{
+			stride *= rows;
+			rows    = 1;
+		}
+
+		auto sample = first / Bits;
+		auto skip   = int(first % Bits);
+		auto end    = bits + (last - first) / 8;
+		auto x      = sample % stride;
+		auto acc    = uint32_t(0);
+		auto n      = 0;
+
+		for (auto y = int(sample / stride); y < rows && bits < end; y++, x = 0)
+		{
+			auto in = img.ptr<sample_type>(y);
+
+			for (; x < stride && bits < end; x++)
+			{
+				acc  |= (uint32_t(in[x]) & mask) >> skip << n;
+				n    += Bits - skip;
+				skip  = 0;
+
+				if (n >= 8)
+				{
+					*bits++ = uint8_t(acc);
+					acc >>= 8;
+					n    -= 8;
+				}
+			}
+		}
+	}
+
+	/*!
+	 * Hides a payload in an image, visiting the samples in a keyed order.
+	 * Sample `order(i)` of the image carries the bits hidden by the `i`th sample in raster order.
+	 * The payload is read in ascending order, so its window moves sequentially.
+	 *
+	 * \param src Input image.
+	 * \param dst Output image of the same size and type, may be the same as `src`.
+	 * \param payload Payload to hide, read through a window of bounded size.
+	 * \param size Number of bits to hide, the bits past the end of the payload are zeros.
+	 * \param mode Storage mode, see STORE_* constants.
+	 * \param order Permutation of the samples of the image.
+	 */
+	static void embed(const cv::Mat& src, cv::Mat& dst, const Payload& payload, int64_t size, int mode, const Permutation& order)
+	{
+		if (order.identity())
+		{
+			embed(src, dst, payload, size, mode);
+			return;
+		}
+
+		LsbPayloadReader bits(payload);
+
+		auto stride = int64_t(src.cols) * channels;
+		auto total  = stride * src.rows;
+		auto needed = (size + Bits - 1) / Bits;
+		auto count  = mode == STORE_ONCE ? std::min(needed, total) : total;
+
+		for (int64_t i = 0; i < count; i++)
+		{
+			auto s = int64_t(order(uint64_t(i)));
+			auto y = int(s / stride);
+			auto x = s % stride;
+			auto j = mode == STORE_REPEAT ? i % needed : i;
+
+			dst.ptr<sample_type>(y)[x] = sample_type((src.ptr<sample_type>(y)[x] & ~mask) | (j < needed ? bits(j * Bits, mask) : 0));
+		}
+	}
+
+	/*!
+	 * Recovers a range of the payload hidden in an image in a keyed order.
+	 *
+	 * \param img Input image with hidden data.
+	 * \param bits Payload, the bytes covered have to be cleared beforehand.
+	 * \param first Index of the first payload bit to recover, a multiple of 8.
+	 * \param last Index after the last payload bit to recover, a multiple of 8.
+	 * \param order Permutation of the samples of the image.
+	 */
+	static void extract(const cv::Mat& img, unsigned char* bits, int64_t first, int64_t last, const Permutation& order)
+	{
+		if (order.identity())
+		{
+			extract(img, bits, first, last);
+			return;
+		}
+
+		auto stride = int64_t(img.cols) * channels;
+		auto total  = stride * img.rows;
+		auto skip   = int(first % Bits);
+		auto end    = bits + (last - first) / 8;
+		auto acc    = uint32_t(0);
+		auto n      = 0;
+
+		for (auto i = first / Bits; i < total && bits < end; i++)
+		{
+			auto s = int64_t(order(uint64_t(i)));
+
+			acc  |= (uint32_t(img.ptr<sample_type>(int(s / stride))[s % stride]) & mask) >> skip << n;
+			n    += Bits - skip;
+			skip  = 0;
+
+			if (n >= 8)
+			{
+				*bits++ = uint8_t(acc);
+				acc >>= 8;
+				n    -= 8;
+			}
+		}
+	}
+};
+
+/*!
+ * Calls a function with the `LsbEngine` instantiated for a pixel type and the number of bits per sample.
+ *
+ * \tparam Pixel Type of a pixel.
+ * \param bits Number of bits altered per sample.
+ * \param function Function receiving an instance of the engine.
+ *
+ * \return Value indicating whether the number of bits is supported.
+ */
+template<typename Pixel, typename Function>
+inline bool lsb_dispatch_bits(int bits, Function& function)
+{
+	switch (bits)
+	{
+	case 1: function(LsbEngine<Pixel, 1>()); return true;
+	case 2: function(LsbEngine<Pixel, 2>()); return true;
+	case 3: function(LsbEngine<Pixel, 3>()); return true;
+	case 4: function(LsbEngine<Pixel, 4>()); return true;
+	default: return false;
+	}
+}
+
+/*!
+ * Calls a function with the `LsbEngine` instantiated for the type of an image and the number of bits per sample.
+ * Images with 8-bit or 16-bit unsigned samples and 1, 3 or 4 channels are supported.
+ *
+ * \param type Type of the image.
+ * \param bits Number of bits altered per sample.
+ * \param function Function receiving an instance of the engine.
+ *
+ * \return Value indicating whether the type and the number of bits are supported.
+ */
+template<typename Function>
+inline bool lsb_dispatch(int type, int bits, Function function)
+{
+	switch (type)
+	{
+	case CV_8UC1:  return lsb_dispatch_bits<uchar>(bits, function);
+	case CV_8UC3:  return lsb_dispatch_bits<cv::Vec3b>(bits, function);
+	case CV_8UC4:  return lsb_dispatch_bits<cv::Vec4b>(bits, function);
+	case CV_16UC1: return lsb_dispatch_bits<ushort>(bits, function);
+	case CV_16UC3: return lsb_dispatch_bits<cv::Vec3w>(bits, function);
+	case CV_16UC4: return lsb_dispatch_bits<cv::Vec4w>(bits, function);
+	default: return false;
+	}
+}
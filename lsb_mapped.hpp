@@ -0,0 +1,468 @@
+#pragma once
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "helpers.hpp"
+#include "lsb_kernel.hpp"
+#include "tlv.hpp"
+
+/*!
+ * Uncompressed raster file mapped into memory, giving direct access to its pixel array.
+ *
+ * Supported are uncompressed 24-bit BMP files, stored either bottom-up or top-down,
+ * and binary PPM (P6) and PGM (P5) files with at most 8 bits per sample. Rows are
+ * addressed in the top-down order `imread` would decode them in, and as PPM files
+ * store the samples as RGB instead of BGR, they are flagged as swapped.
+ */
+class MappedRaster
+{
+public:
+
+	/*!
+	 * Initializes an unmapped instance.
+	 */
+	MappedRaster()
+		: rows(0), cols(0), channels(0), swapped(false), pixels(nullptr), step(0)
+	{
+	}
+
+	/*!
+	 * Maps a raster file and parses its header.
+	 *
+	 * \param file Path to the raster file.
+	 * \param writable Value indicating whether the pixels will be altered.
+	 *
+	 * \return Value indicating whether the file was mapped and its format is supported.
+	 */
+	bool open(const std::string& file, bool writable)
+	{
+		using namespace boost::interprocess;
+
+		try
+		{
+			auto access = writable ? read_write : read_only;
+
+			mapping = file_mapping(file.c_str(), access);
+			region  = mapped_region(mapping, access);
+		}
+		catch (const interprocess_exception&)
+		{
+			return false;
+		}
+
+		auto data = static_cast<uchar*>(region.get_address());
+		auto size = int64_t(region.get_size());
+
+		return parse_bmp(data, size) || parse_pnm(data, size);
+	}
+
+	/*!
+	 * Returns the samples of a row.
+	 *
+	 * \param y Index of the row, counted from the top of the image.
+	 *
+	 * \return Pointer to the first sample of the row within the mapping.
+	 */
+	uchar* row(int y) const
+	{
+		return pixels + (step < 0 ? int64_t(rows - 1 - y) * -step : int64_t(y) * step);
+	}
+
+	/*!
+	 * Writes the altered pages back to the file, and waits for the write to finish.
+	 *
+	 * \return Value indicating whether the operation was successful.
+	 */
+	bool flush()
+	{
+		return region.flush(0, 0, false);
+	}
+
+	/*!
+	 * Number of rows in the image.
+	 */
+	int rows;
+
+	/*!
+	 * Number of columns in the image.
+	 */
+	int cols;
+
+	/*!
+	 * Number of samples per pixel.
+	 */
+	int channels;
+
+	/*!
+	 * Value indicating whether the first and third samples of each pixel are swapped compared to `imread`.
+	 */
+	bool swapped;
+
+private:
+
+	/*!
+	 * Reads a little-endian integer from the header.
+	 */
+	static uint32_t read_le(const uchar* data, int bytes)
+	{
+		uint32_t value = 0;
+
+		for (int i = bytes - 1; i >= 0; i--)
+		{
+			value = value << 8 | data[i];
+		}
+
+		return value;
+	}
+
+	/*!
+	 * Parses the header of an uncompressed 24-bit BMP file.
+	 */
+	bool parse_bmp(uchar* data, int64_t size)
+	{
+		if (size < 54 || data[0] != 'B' || data[1] != 'M' || read_le(data + 14, 4) < 40)
+		{
+			return false;
+		}
+
+		auto offset = int64_t(read_le(data + 10, 4));
+		auto width  = int32_t(read_le(data + 18, 4));
+		auto height = int32_t(read_le(data + 22, 4));
+
+		// only BI_RGB with 8 bits per sample is stored as plain samples
+		if (read_le(data + 28, 2) != 24 || read_le(data + 30, 4) != 0 || width <= 0 || height == 0 || height == INT32_MIN)
+		{
+			return false;
+		}
+
+		// rows are padded to 4 bytes, and stored bottom-up unless the height is negative
+		auto stride = (int64_t(width) * 3 + 3) & ~int64_t(3);
+
+		// the pixels may not overlap the headers, and the product is bounded by division to avoid overflow
+		if (offset < 54 || offset > size || stride > (size - offset) / std::abs(height))
+		{
+			return false;
+		}
+
+		rows     = std::abs(height);
+		cols     = width;
+		channels = 3;
+		swapped  = false;
+		pixels   = data + offset;
+		step     = height > 0 ? -stride : stride;
+
+		return true;
+	}
+
+	/*!
+	 * Parses the header of a binary PPM or PGM file.
+	 */
+	bool parse_pnm(uchar* data, int64_t size)
+	{
+		if (size < 3 || data[0] != 'P' || (data[1] != '5' && data[1] != '6'))
+		{
+			return false;
+		}
+
+		int64_t values[3];
+		int64_t position = 2;
+
+		for (auto& value : values)
+		{
+			// whitespace and comments running to the end of the line may precede each value
+			while (position < size && (isspace(data[position]) || data[position] == '#'))
+			{
+				if (data[position] == '#')
+				{
+					while (position < size && data[position] != '\n')
+					{
+						position++;
+					}
+				}
+				else
+				{
+					position++;
+				}
+			}
+
+			if (position >= size || !isdigit(data[position]))
+			{
+				return false;
+			}
+
+			value = 0;
+
+			while (position < size && isdigit(data[position]) && value < INT32_MAX)
+			{
+				value = value * 10 + (data[position++] - '0');
+			}
+		}
+
+		// a single whitespace separates the header from the pixels
+		if (position >= size || !isspace(data[position]))
+		{
+			return false;
+		}
+
+		position++;
+
+		auto depth  = data[1] == '6' ? 3 : 1;
+		auto stride = values[0] * depth;
+
+		if (values[0] <= 0 || values[1] <= 0 || values[2] <= 0 || values[2] > 255 || values[0] >= INT32_MAX || values[1] >= INT32_MAX || stride > (size - position) / values[1])
+		{
+			return false;
+		}
+
+		rows     = int(values[1]);
+		cols     = int(values[0]);
+		channels = depth;
+		swapped  = depth == 3;
+		pixels   = data + position;
+		step     = stride;
+
+		return true;
+	}
+
+	boost::interprocess::file_mapping mapping;
+	boost::interprocess::mapped_region region;
+	uchar* pixels;
+	int64_t step;
+};
+
+/*!
+ * Swaps the first and third samples of each pixel while copying a row,
+ * converting between the RGB order of PPM files and the BGR order of `imread`.
+ *
+ * \param src Samples of the input row.
+ * \param dst Samples of the output row, may not overlap the input.
+ * \param cols Number of 3-sample pixels in the row.
+ */
+inline void lsb_mapped_swap(const uchar* src, uchar* dst, int cols)
+{
+	for (int x = 0; x < cols; x++, src += 3, dst += 3)
+	{
+		dst[0] = src[2];
+		dst[1] = src[1];
+		dst[2] = src[0];
+	}
+}
+
+/*!
+ * Determines whether an image file can be altered through a memory mapping.
+ *
+ * \param file Path to the image.
+ *
+ * \return Value indicating whether the file is an uncompressed raster supported by `MappedRaster`.
+ */
+inline bool lsb_mapped_supported(const std::string& file)
+{
+	MappedRaster raster;
+	return raster.open(file, false);
+}
+
+/*!
+ * Hides data in an uncompressed raster file by manipulating the least significant bit of each sample
+ * directly within the memory-mapped pixel array, without decoding or encoding the image. The result
+ * is identical to `encode_lsb` applied to the image as decoded by `imread`.
+ *
+ * \param input Path to the original image.
+ * \param output Path to write the altered image to, or an empty string to alter the original in place.
+ * \param payload Payload to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ *
+ * \return Value indicating whether the operation was successful.
+ */
+inline bool encode_lsb_mapped(const std::string& input, const std::string& output, const Payload& payload, int mode = STORE_ONCE)
+{
+	using namespace std;
+
+	if (!output.empty() && output != input)
+	{
+		ifstream src(input, ios::binary);
+		ofstream dst(output, ios::binary | ios::trunc);
+
+		if (!src || !dst || !(dst << src.rdbuf()))
+		{
+			return false;
+		}
+	}
+
+	MappedRaster raster;
+
+	if (!raster.open(output.empty() ? input : output, true))
+	{
+		return false;
+	}
+
+	// the terminating null character is hidden as well, as done by `encode_lsb`
+	auto size   = (payload.size() + 1) * 8;
+	auto stride = int64_t(raster.cols) * raster.channels;
+
+	vector<uchar> scratch(raster.swapped ? size_t(stride) : 0);
+
+	for (int y = 0; y < raster.rows; y++)
+	{
+		auto row     = raster.row(y);
+		auto samples = raster.swapped ? scratch.data() : row;
+
+		if (raster.swapped)
+		{
+			lsb_mapped_swap(row, samples, raster.cols);
+		}
+
+		auto more = lsb_embed_run(y * stride, stride, size, mode,
+			[&](int64_t offset, int64_t first, int64_t count) { lsb_embed_payload(samples + offset, samples + offset, payload, first, count); },
+			[&](int64_t offset, int64_t count) { lsb_clear_bits(samples + offset, samples + offset, count); });
+
+		if (raster.swapped)
+		{
+			lsb_mapped_swap(samples, row, raster.cols);
+		}
+
+		if (!more)
+		{
+			break;
+		}
+	}
+
+	return raster.flush();
+}
+
+/*!
+ * Hides text in an uncompressed raster file by manipulating the least significant bit of each sample
+ * directly within the memory-mapped pixel array. The result is identical to `encode_lsb`.
+ *
+ * \param input Path to the original image.
+ * \param output Path to write the altered image to, or an empty string to alter the original in place.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ *
+ * \return Value indicating whether the operation was successful.
+ */
+inline bool encode_lsb_mapped(const std::string& input, const std::string& output, const std::string& text, int mode = STORE_ONCE)
+{
+	return encode_lsb_mapped(input, output, Payload().append(text.data(), int64_t(text.length())), mode);
+}
+
+/*!
+ * Recovers a range of the data hidden in an uncompressed raster file using least significant bit
+ * manipulation, reading the memory-mapped pixel array up to the last row carrying the requested bytes.
+ * The data is written to a stream in chunks, so it does not have to fit in memory.
+ *
+ * \param input Path to the image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ * \param out Stream to write the extracted data to.
+ *
+ * \return Number of bytes written, fewer than requested if the image is too small,
+ *         or -1 if the file is not supported.
+ */
+inline int64_t decode_lsb_mapped_range_to(const std::string& input, int64_t offset, int64_t length, std::ostream& out)
+{
+	using namespace std;
+
+	MappedRaster raster;
+
+	if (!raster.open(input, false))
+	{
+		return -1;
+	}
+
+	auto stride = int64_t(raster.cols) * raster.channels;
+	auto first  = offset * 8;
+	auto last   = first + max(int64_t(0), min(length, stride * raster.rows / 8 - offset)) * 8;
+
+	LsbWriter writer(out, first, last);
+
+	vector<uchar> scratch(raster.swapped ? size_t(stride) : 0);
+
+	for (auto b = first; b < last;)
+	{
+		auto y = int(b / stride);
+		auto x = b % stride;
+		auto n = min(last - b, stride - x);
+
+		auto samples = raster.row(y);
+
+		if (raster.swapped)
+		{
+			lsb_mapped_swap(samples, scratch.data(), raster.cols);
+			samples = scratch.data();
+		}
+
+		if (!writer.extract(samples + x, b, n))
+		{
+			break;
+		}
+
+		b += n;
+	}
+
+	return writer.written();
+}
+
+/*!
+ * Recovers a range of the data hidden in an uncompressed raster file using least significant bit
+ * manipulation, reading the memory-mapped pixel array up to the last row carrying the requested bytes.
+ *
+ * \param input Path to the image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ *
+ * \return Hidden data extracted form image, shorter than requested if the image is too small,
+ *         or an empty string if the file is not supported.
+ */
+inline std::string decode_lsb_mapped_range(const std::string& input, int64_t offset, int64_t length)
+{
+	std::ostringstream out;
+	decode_lsb_mapped_range_to(input, offset, length, out);
+	return out.str();
+}
+
+/*!
+ * Recovers data hidden in an uncompressed raster file using least significant bit manipulation.
+ *
+ * \param input Path to the image with hidden data.
+ *
+ * \return Hidden data extracted form image.
+ */
+inline std::string decode_lsb_mapped(const std::string& input)
+{
+	return decode_lsb_mapped_range(input, 0, INT64_MAX);
+}
+
+/*!
+ * Recovers data encapsulated with `encode_tlv` and hidden in an uncompressed raster file using least
+ * significant bit manipulation. The header is extracted first, and only the rows up to the end of the
+ * payload are read afterwards.
+ *
+ * \param input Path to the image with hidden data.
+ *
+ * \return Hidden data extracted form image, or an empty string if the header is invalid.
+ */
+inline std::string decode_lsb_mapped_tlv(const std::string& input)
+{
+	return decode_tlv_lazy([&](int64_t offset, int64_t length) { return decode_lsb_mapped_range(input, offset, length); });
+}
+
+/*!
+ * Recovers data encapsulated with `encode_tlv` and hidden in an uncompressed raster file using least
+ * significant bit manipulation, writing the data to a stream in chunks.
+ *
+ * \param input Path to the image with hidden data.
+ * \param out Stream to write the extracted data to.
+ *
+ * \return Number of bytes written, or -1 if the header is invalid or the file is not supported.
+ */
+inline int64_t decode_lsb_mapped_tlv_to(const std::string& input, std::ostream& out)
+{
+	return decode_tlv_stream([&](int64_t offset, int64_t length, std::ostream& stream) { return decode_lsb_mapped_range_to(input, offset, length, stream); }, out);
+}
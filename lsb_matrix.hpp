@@ -0,0 +1,325 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "helpers.hpp"
+#include "lsb_kernel.hpp"
+#include "payload.hpp"
+#include "tlv.hpp"
+
+/*!
+ * Largest number of bits hidden per group of samples by matrix embedding.
+ */
+#define LSB_MATRIX_MAX 10
+
+/*!
+ * Number of payload bytes read ahead by the matrix encoder.
+ */
+#define LSB_MATRIX_WINDOW 4096
+
+/*!
+ * Returns the lookup table of the syndrome contributed by each byte of packed bits.
+ *
+ * The samples of a group are numbered from 1, so packed with a leading zero bit, the
+ * bit `t` of byte `j` belongs to sample `8j + t`. As `t < 8`, the number of the sample
+ * is `8j | t`, and the syndrome of a byte is the XOR of the `t` of its set bits, plus
+ * `8j` if an odd number of bits are set. The table holds the former in its low 3 bits,
+ * and the parity of the byte in its fourth bit.
+ *
+ * \return Table indexed by the packed byte.
+ */
+inline const uint8_t* lsb_matrix_table()
+{
+	struct Table
+	{
+		uint8_t entries[256];
+
+		Table()
+		{
+			for (int b = 0; b < 256; b++)
+			{
+				entries[b] = 0;
+
+				for (int t = 0; t < 8; t++)
+				{
+					if (b >> t & 1)
+					{
+						entries[b] ^= t | 8;
+					}
+				}
+			}
+		}
+	};
+
+	static const Table table;
+	return table.entries;
+}
+
+/*!
+ * Computes the syndrome of a group of samples under the (1, 2^k-1, k) Hamming code,
+ * which is the XOR of the numbers of the samples with their least significant bit set.
+ *
+ * \param packed Least significant bits of the group, preceded by a zero bit.
+ * \param bytes Number of bytes covering the packed bits.
+ *
+ * \return Syndrome of the group.
+ */
+inline int lsb_matrix_syndrome(const unsigned char* packed, int bytes)
+{
+	auto table    = lsb_matrix_table();
+	auto syndrome = 0;
+
+	for (int j = 0; j < bytes; j++)
+	{
+		auto entry = table[packed[j]];
+
+		syndrome ^= (entry & 7) | (entry & 8 ? j << 3 : 0);
+	}
+
+	return syndrome;
+}
+
+/*!
+ * Computes the syndrome of a group of samples.
+ *
+ * \param samples Samples of the group.
+ * \param n Number of samples in the group, 2^k-1.
+ * \param packed Buffer of at least `(n + 8) / 8` bytes for the packed bits.
+ *
+ * \return Syndrome of the group.
+ */
+inline int lsb_matrix_group(const unsigned char* samples, int n, unsigned char* packed)
+{
+	auto bytes = (n + 8) / 8;
+
+	memset(packed, 0, bytes);
+	lsb_extract_bits(samples, packed, 1, n);
+
+	return lsb_matrix_syndrome(packed, bytes);
+}
+
+/*!
+ * Calculates the number of bits which can be hidden in an image with matrix embedding.
+ *
+ * \param img Input image.
+ * \param k Number of bits hidden per group of 2^k-1 samples.
+ *
+ * \return Capacity of the image in bits.
+ */
+inline int64_t lsb_matrix_capacity(const cv::Mat& img, int k)
+{
+	return int64_t(img.total()) * img.channels() / ((1 << k) - 1) * k;
+}
+
+/*!
+ * Hides data in an image with matrix embedding, altering the pixels of the specified image.
+ *
+ * The samples are split into groups of 2^k-1 in raster order, and each group carries
+ * k bits of the payload as the syndrome of its least significant bits under the
+ * (1, 2^k-1, k) Hamming code, as done by F5. The syndrome is brought to the payload
+ * bits by flipping at most one bit per group, so fewer samples are changed per hidden
+ * bit than with `encode_lsb`, in exchange for a lower capacity.
+ *
+ * \param img Image to alter, with 8-bit samples.
+ * \param payload Payload to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param k Number of bits hidden per group, 1 to LSB_MATRIX_MAX.
+ *
+ * \return Number of samples changed, or -1 if the image type or `k` is not supported.
+ */
+inline int64_t encode_lsb_matrix_inplace(cv::Mat& img, const Payload& payload, int mode = STORE_ONCE, int k = 3)
+{
+	using namespace cv;
+	using namespace std;
+
+	if (img.depth() != CV_8U || k < 1 || k > LSB_MATRIX_MAX)
+	{
+		return -1;
+	}
+
+	// groups span rows, so the samples have to be contiguous
+	auto work = img.isContinuous() ? img : img.clone();
+
+	auto samples = work.ptr<uchar>(0);
+	auto n       = (1 << k) - 1;
+	auto groups  = int64_t(work.total()) * work.channels() / n;
+
+	// the terminating null character is hidden as well, as done by `encode_lsb`
+	auto size    = (payload.size() + 1) * 8;
+	auto changes = int64_t(0);
+
+	vector<uchar> packed((n + 8) / 8);
+	vector<uchar> window(LSB_MATRIX_WINDOW);
+	auto window_first = int64_t(-1);
+
+	auto bit = [&](int64_t b)
+	{
+		if (b >= size)
+		{
+			if (mode != STORE_REPEAT)
+			{
+				return 0;
+			}
+
+			b %= size;
+		}
+
+		if (window_first < 0 || b / 8 < window_first || b / 8 >= window_first + LSB_MATRIX_WINDOW)
+		{
+			window_first = b / 8;
+			payload.read(window_first, LSB_MATRIX_WINDOW, window.data());
+		}
+
+		return window[size_t(b / 8 - window_first)] >> (b % 8) & 1;
+	};
+
+	for (int64_t g = 0; g < groups; g++)
+	{
+		auto first = g * k;
+
+		if (first >= size && mode == STORE_ONCE)
+		{
+			break;
+		}
+
+		auto message = 0;
+
+		for (int i = 0; i < k; i++)
+		{
+			message |= bit(first + i) << i;
+		}
+
+		auto group = samples + g * n;
+		auto flip  = lsb_matrix_group(group, n, packed.data()) ^ message;
+
+		if (flip != 0)
+		{
+			group[flip - 1] ^= 1;
+			changes++;
+		}
+	}
+
+	if (work.data != img.data)
+	{
+		work.copyTo(img);
+	}
+
+	return changes;
+}
+
+/*!
+ * Hides text in an image with matrix embedding, altering the pixels of the specified image.
+ *
+ * \param img Image to alter, with 8-bit samples.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param k Number of bits hidden per group, 1 to LSB_MATRIX_MAX.
+ *
+ * \return Number of samples changed, or -1 if the image type or `k` is not supported.
+ */
+inline int64_t encode_lsb_matrix_inplace(cv::Mat& img, const std::string& text, int mode = STORE_ONCE, int k = 3)
+{
+	return encode_lsb_matrix_inplace(img, Payload().append(text.data(), int64_t(text.length())), mode, k);
+}
+
+/*!
+ * Hides data in an image with matrix embedding.
+ *
+ * \param img Input image, with 8-bit samples.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param k Number of bits hidden per group, 1 to LSB_MATRIX_MAX.
+ *
+ * \return Altered image with hidden data, or an empty image if the image type or `k` is not supported.
+ */
+inline cv::Mat encode_lsb_matrix(const cv::Mat& img, const std::string& text, int mode = STORE_ONCE, int k = 3)
+{
+	cv::Mat stego;
+	img.copyTo(stego);
+
+	if (encode_lsb_matrix_inplace(stego, text, mode, k) < 0)
+	{
+		return cv::Mat();
+	}
+
+	return stego;
+}
+
+/*!
+ * Recovers a range of the data hidden in an image with matrix embedding.
+ * Only the groups carrying the requested bytes are read.
+ *
+ * \param img Input image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ * \param k Number of bits hidden per group, 1 to LSB_MATRIX_MAX.
+ *
+ * \return Hidden data extracted form image, shorter than requested if the image is too small,
+ *         or an empty string if the image type or `k` is not supported.
+ */
+inline std::string decode_lsb_matrix_range(const cv::Mat& img, int64_t offset, int64_t length, int k = 3)
+{
+	using namespace cv;
+	using namespace std;
+
+	if (img.depth() != CV_8U || k < 1 || k > LSB_MATRIX_MAX)
+	{
+		return string();
+	}
+
+	auto work = img.isContinuous() ? img : img.clone();
+
+	auto samples = work.ptr<uchar>(0);
+	auto n       = (1 << k) - 1;
+
+	string text(size_t(max(int64_t(0), min(length, lsb_matrix_capacity(work, k) / 8 - offset))), 0);
+
+	auto first = offset * 8;
+	auto last  = first + int64_t(text.length()) * 8;
+	auto bytes = reinterpret_cast<uchar*>(&text[0]);
+
+	vector<uchar> packed((n + 8) / 8);
+
+	for (auto b = first; b < last;)
+	{
+		auto g        = b / k;
+		auto syndrome = lsb_matrix_group(samples + g * n, n, packed.data());
+
+		for (auto i = b - g * k; i < k && b < last; i++, b++)
+		{
+			bytes[(b - first) / 8] |= (syndrome >> i & 1) << ((b - first) % 8);
+		}
+	}
+
+	return text;
+}
+
+/*!
+ * Recovers data hidden in an image with matrix embedding.
+ *
+ * \param img Input image with hidden data.
+ * \param k Number of bits hidden per group, 1 to LSB_MATRIX_MAX.
+ *
+ * \return Hidden data extracted form image.
+ */
+inline std::string decode_lsb_matrix(const cv::Mat& img, int k = 3)
+{
+	return decode_lsb_matrix_range(img, 0, INT64_MAX, k);
+}
+
+/*!
+ * Recovers data encapsulated with `encode_tlv` and hidden with matrix embedding.
+ * The header is extracted first, and only the groups covered by the payload are read afterwards.
+ *
+ * \param img Input image with hidden data.
+ * \param k Number of bits hidden per group, 1 to LSB_MATRIX_MAX.
+ *
+ * \return Hidden data extracted form image, or an empty string if the header is invalid.
+ */
+inline std::string decode_lsb_matrix_tlv(const cv::Mat& img, int k = 3)
+{
+	return decode_tlv_lazy([&](int64_t offset, int64_t length) { return decode_lsb_matrix_range(img, offset, length, k); });
+}
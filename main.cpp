@@ -8,12 +8,20 @@
 #include "helpers.hpp"
 #include "lsb.hpp"
 #include "lsb_alt.hpp"
+#include "lsb_mapped.hpp"
+#include "lsb_matrix.hpp"
 #include "dct.hpp"
+#include "dct_jpeg.hpp"
 #include "dwt.hpp"
+#include "dwt_cache.hpp"
+#include "stream.hpp"
 #include "tlv.hpp"
+#include "video.hpp"
 
 #if _WIN32
 	#include <conio.h>
+	#include <fcntl.h>
+	#include <io.h>
 #else
 	#define _getche getchar
 #endif
@@ -23,17 +31,14 @@ using namespace std;
 using namespace boost;
 
 /*!
- * Evaluates the similarity and prints the original and resulting strings.
+ * Selects the color to print a similarity with.
  *
- * \param input Original input.
- * \param output Extracted output.
+ * \param accuracy Similarity in percentages.
+ *
+ * \return Green for a perfect match, yellow for minor errors, red otherwise.
  */
-void print_debug(const string& input, const string& output)
+Format::ColorCode similarity_color(float accuracy)
 {
-	auto original  = clean(input);
-	auto extracted = clean(output);
-	auto accuracy  = similarity(original, extracted);
-
 	Format::ColorCode color;
 
 	if (accuracy > 99.99)
@@ -49,12 +54,59 @@ void print_debug(const string& input, const string& output)
 		color = Format::Red;
 	}
 
+	return color;
+}
+
+/*!
+ * Evaluates the similarity and prints the original and resulting strings.
+ *
+ * \param input Original input.
+ * \param output Extracted output.
+ */
+void print_debug(const string& input, const string& output)
+{
+	auto original  = clean(input);
+	auto extracted = clean(output);
+	auto accuracy  = similarity(original, extracted);
+	auto color     = similarity_color(accuracy);
+
 	cout << endl
 		 << "  Similarity: " << setprecision(3) << color << Format::Bold << accuracy << "%" << Format::Normal << Format::Default << endl << endl
 		 << "  Input:"       << endl << endl << Format::White << Format::Bold << original  << Format::Normal << Format::Default << endl << endl
 		 << "  Extracted:"   << endl << endl << Format::White << Format::Bold << extracted << Format::Normal << Format::Default << endl;
 }
 
+/*!
+ * Evaluates the similarity of a payload and the extracted output. Short payloads are printed
+ * as text, longer ones are streamed into a comparison with the payload without being stored
+ * or printed, so verifying a large payload takes bounded memory.
+ *
+ * \param input Original payload.
+ * \param extract Function writing the extracted output to a stream.
+ */
+void print_debug(const Payload& input, const std::function<void(ostream& out)>& extract)
+{
+	if (input.size() <= 4096)
+	{
+		ostringstream output;
+		extract(output);
+
+		print_debug(input.str(), output.str());
+		return;
+	}
+
+	PayloadMatcher matcher(input);
+	ostream output(&matcher);
+
+	extract(output);
+
+	auto accuracy = float(matcher.matched() * 100.0 / input.size());
+
+	cout << endl
+		 << "  Similarity: " << setprecision(3) << similarity_color(accuracy) << Format::Bold << accuracy << "%" << Format::Normal << Format::Default << endl << endl
+		 << "  Compared " << input.size() << " bytes of input with " << matcher.written() << " bytes extracted." << endl;
+}
+
 /*!
  * Displays the original image and pre-steganography histogram.
  */
@@ -91,7 +143,7 @@ void test_lsb()
 
 	auto input  = read_file("test/test.txt");
 	auto stego  = encode_lsb(img, encode_tlv(input));
-	auto output = decode_tlv(decode_lsb(stego));
+	auto output = decode_lsb_tlv(stego);
 
 	print_debug(input, output);
 
@@ -109,13 +161,113 @@ void test_lsb_alt()
 
 	auto input  = read_file("test/test.txt");
 	auto stego  = encode_lsb_alt(img, encode_tlv(input));
-	auto output = decode_tlv(decode_lsb_alt(stego));
+	auto output = decode_lsb_alt_tlv(stego);
+
+	print_debug(input, output);
+
+	show_image(stego, "Altered");
+}
+
+/*!
+ * Tests the least significat bit method with multiple bits per sample on a 16-bit image.
+ */
+void test_lsb_bits()
+{
+	auto img = imread("test/img_small.png");
+
+	show_image(img, "Original");
+
+	Mat deep;
+	img.convertTo(deep, CV_16U, 257);
+
+	auto input  = read_file("test/test.txt");
+	auto stego  = encode_lsb(deep, encode_tlv(input), STORE_ONCE, 4);
+	auto output = decode_lsb_tlv(stego, 4);
 
 	print_debug(input, output);
 
 	show_image(stego, "Altered");
 }
 
+/*!
+ * Tests the least significat bit method with matrix embedding, comparing the number of changed samples.
+ */
+void test_lsb_matrix()
+{
+	auto img = imread("test/img_small.png");
+
+	show_image(img, "Original");
+
+	auto input  = read_file("test/test.txt");
+	auto packet = encode_tlv(input);
+	auto plain  = encode_lsb(img, packet);
+
+	Mat diff;
+	absdiff(img, plain, diff);
+
+	auto stego   = img.clone();
+	auto changes = encode_lsb_matrix_inplace(stego, packet, STORE_ONCE, 4);
+	auto output  = decode_lsb_matrix_tlv(stego, 4);
+
+	cout << endl << "  Changed samples: " << countNonZero(diff.reshape(1)) << " without, " << changes << " with matrix embedding." << endl;
+
+	print_debug(input, output);
+
+	show_image(stego, "Altered");
+}
+
+/*!
+ * Tests the least significat bit methods with a keyed embedding order, extracting with the
+ * correct key and without one, which is expected to find no valid header.
+ */
+void test_lsb_keyed()
+{
+	auto img = imread("test/img_small.png");
+
+	show_image(img, "Original");
+
+	auto input  = read_file("test/test.txt");
+	auto packet = encode_tlv(input);
+	auto key    = string("correct horse battery staple");
+
+	auto stego  = encode_lsb(img, packet, STORE_ONCE, 1, key);
+	auto alt    = encode_lsb_alt(img, packet, STORE_ONCE, key);
+	auto output = decode_lsb_tlv(stego, 1, key);
+
+	cout << endl << "  Without key: " << decode_lsb_tlv(stego).length() << " bytes from all channels, " << decode_lsb_alt_tlv(alt).length() << " bytes from alternating channels." << endl;
+
+	print_debug(input, decode_lsb_alt_tlv(alt, key));
+	print_debug(input, output);
+
+	show_image(stego, "Altered");
+}
+
+/*!
+ * Tests the least significat bit method on a memory-mapped BMP image.
+ */
+void test_lsb_mapped()
+{
+	auto img = imread("test/img_small.png");
+
+	show_image(img, "Original");
+
+	imwrite("test/img_small.bmp", img);
+
+	auto input = read_file("test/test.txt");
+
+	if (!encode_lsb_mapped("test/img_small.bmp", "test/img_mapped.bmp", encode_tlv(input)))
+	{
+		cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to map 'test/img_mapped.bmp'." << endl << endl;
+		return;
+	}
+
+	auto output = decode_lsb_mapped_tlv("test/img_mapped.bmp");
+
+	print_debug(input, output);
+
+	show_image(imread("test/img_mapped.bmp"), "Altered");
+}
+
 /*!
  * Tests the discrete cosine transformation method.
  */
@@ -145,9 +297,7 @@ void test_dct_multi()
 	show_image(img, "Original");
 
 	auto input = read_file("test/test.txt");
-	auto stego = encode_dct(img,   input, STORE_FULL, 0);
-	     stego = encode_dct(stego, input, STORE_FULL, 1);
-		 stego = encode_dct(stego, input, STORE_FULL, 2);
+	auto stego = encode_dct(img, input, STORE_FULL, vector<int> { 0, 1, 2 });
 
 	imwrite("test/lena_dct.jpg", stego, vector<int> { CV_IMWRITE_JPEG_QUALITY, 80 });
 	stego = imread("test/lena_dct.jpg");
@@ -164,6 +314,31 @@ void test_dct_multi()
 	show_image(stego, "Altered");
 }
 
+/*!
+ * Tests the quantized JPEG coefficient method with multi-component message reconstruction.
+ */
+void test_dct_jpeg()
+{
+	auto img = imread("test/lena.jpg");
+
+	show_image(img, "Original");
+
+	auto input = read_file("test/test.txt");
+
+	encode_dct_jpeg("test/lena.jpg", "test/lena_coef.jpg", input, STORE_FULL, vector<int> { 0, 1, 2 });
+
+	auto output = repair(vector<string>
+		{
+			decode_dct_jpeg("test/lena_coef.jpg", 0),
+			decode_dct_jpeg("test/lena_coef.jpg", 1),
+			decode_dct_jpeg("test/lena_coef.jpg", 2)
+		});
+
+	print_debug(input, output);
+
+	show_image(imread("test/lena_coef.jpg"), "Altered");
+}
+
 /*!
  * Tests the discrete wavelet transformation method.
  */
@@ -212,6 +387,320 @@ void test_dwt_multi()
 	show_image(stego, "Altered");
 }
 
+/*!
+ * Tests the blind discrete wavelet transformation method with 90% JPEG compression
+ * and multi-channel message reconstruction.
+ */
+void test_dwt_blind()
+{
+	auto img = imread("test/lena.jpg");
+
+	show_image(img, "Original");
+
+	auto input = read_file("test/test.txt");
+	auto stego = encode_dwt_blind(img,   input, STORE_FULL, 0);
+	     stego = encode_dwt_blind(stego, input, STORE_FULL, 1);
+	     stego = encode_dwt_blind(stego, input, STORE_FULL, 2);
+
+	imwrite("test/lena_dwt_blind.jpg", stego, vector<int> { CV_IMWRITE_JPEG_QUALITY, 90 });
+	stego = imread("test/lena_dwt_blind.jpg");
+
+	auto output = repair(vector<string>
+		{
+			decode_dwt_blind(stego, 0),
+			decode_dwt_blind(stego, 1),
+			decode_dwt_blind(stego, 2)
+		});
+
+	print_debug(input, output);
+
+	show_image(stego, "Altered");
+}
+
+/*!
+ * Tests the discrete wavelet transformation method using all detail filters of two decomposition levels
+ * with 90% JPEG compression and multi-channel message reconstruction.
+ */
+void test_dwt_subbands()
+{
+	auto img = imread("test/lena.jpg");
+
+	show_image(img, "Original");
+
+	auto input = read_file("test/test.txt");
+	auto stego = encode_dwt_multi(img,   input, STORE_FULL, 0, 2);
+	     stego = encode_dwt_multi(stego, input, STORE_FULL, 1, 2);
+	     stego = encode_dwt_multi(stego, input, STORE_FULL, 2, 2);
+
+	imwrite("test/lena_dwt_subbands.jpg", stego, vector<int> { CV_IMWRITE_JPEG_QUALITY, 90 });
+	stego = imread("test/lena_dwt_subbands.jpg");
+
+	auto output = repair(vector<string>
+		{
+			decode_dwt_multi(img, stego, 0, 2),
+			decode_dwt_multi(img, stego, 1, 2),
+			decode_dwt_multi(img, stego, 2, 2)
+		});
+
+	print_debug(input, output);
+
+	show_image(stego, "Altered");
+}
+
+/*!
+ * Tests the discrete cosine transformation method on a PNG image processed in strips of 64 rows
+ * with multi-channel message reconstruction.
+ */
+void test_dct_stream()
+{
+	show_image(imread("test/img.png"), "Original");
+
+	auto input = read_file("test/test.txt");
+
+	if (!encode_dct_stream("test/img.png", "test/img_stream.png", input, STORE_FULL, vector<int> { 0, 1, 2 }, 30, 1, 64))
+	{
+		cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to process 'test/img.png'." << endl << endl;
+		return;
+	}
+
+	auto output = repair(vector<string>
+		{
+			decode_dct_stream("test/img_stream.png", 0, 1, 64),
+			decode_dct_stream("test/img_stream.png", 1, 1, 64),
+			decode_dct_stream("test/img_stream.png", 2, 1, 64)
+		});
+
+	print_debug(input, output);
+
+	show_image(imread("test/img_stream.png"), "Altered");
+}
+
+/*!
+ * Benchmarks the allocation-free DCT kernel against `cv::dct` on 8x8 blocks.
+ */
+void bench_dct()
+{
+	const auto blocks = 200000;
+
+	Mat block(8, 8, CV_32F);
+	randu(block, 0, 255);
+
+	Mat trans(8, 8, CV_32F);
+	float coeffs[64];
+
+	volatile auto sink = 0.f;
+
+	auto start = getTickCount();
+
+	for (int i = 0; i < blocks; i++)
+	{
+		dct(block, trans);
+		sink = sink + trans.at<float>(6, 7);
+	}
+
+	auto opencv = (getTickCount() - start) / getTickFrequency() * 1e9 / blocks;
+
+	start = getTickCount();
+
+	for (int i = 0; i < blocks; i++)
+	{
+		Dct<8>::forward(block.ptr<float>(), coeffs);
+		sink = sink + coeffs[6 * 8 + 7];
+	}
+
+	auto kernel = (getTickCount() - start) / getTickFrequency() * 1e9 / blocks;
+
+	start = getTickCount();
+
+	for (int i = 0; i < blocks; i++)
+	{
+		sink = sink + Dct<8>::project(block.ptr<float>(), Dct<8>::basis(6, 7)) + Dct<8>::project(block.ptr<float>(), Dct<8>::basis(5, 1));
+	}
+
+	auto project = (getTickCount() - start) / getTickFrequency() * 1e9 / blocks;
+
+	auto error = 0.f;
+
+	for (int i = 0; i < 64; i++)
+	{
+		error = max(error, abs(coeffs[i] - trans.at<float>(i / 8, i % 8)));
+	}
+
+	cout << endl
+		 << "  cv::dct:           " << Format::White << Format::Bold << setw(8) << fixed << setprecision(1) << opencv  << " ns/block" << Format::Normal << Format::Default << endl
+		 << "  Dct<8>::forward:   " << Format::White << Format::Bold << setw(8) << fixed << setprecision(1) << kernel  << " ns/block" << Format::Normal << Format::Default << " (" << setprecision(2) << opencv / kernel  << "x)" << endl
+		 << "  Dct<8>::project:   " << Format::White << Format::Bold << setw(8) << fixed << setprecision(1) << project << " ns/block" << Format::Normal << Format::Default << " (" << setprecision(2) << opencv / project << "x, 2 coefficients)" << endl
+		 << "  Maximum deviation: " << Format::White << Format::Bold << scientific << setprecision(2) << error << Format::Normal << Format::Default << endl << endl;
+
+	cout.unsetf(ios::floatfield);
+}
+
+/*!
+ * Benchmarks the lifting Haar kernel against the previous per-pixel implementation.
+ */
+void bench_dwt()
+{
+	const auto size = 2048;
+	const auto runs = 10;
+
+	Mat plane(size, size, CV_32F);
+	randu(plane, 0, 1);
+
+	Mat haar1(size, size, CV_32F), haar2(size, size, CV_32F);
+	Mat recon1(size, size, CV_32F), recon2(size, size, CV_32F);
+
+	auto forward = [](const Mat& src, Mat& dst)
+	{
+		auto width  = src.cols / 2;
+		auto height = src.rows / 2;
+
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				dst.at<float>(y,          x)         = (src.at<float>(2 * y, 2 * x) + src.at<float>(2 * y, 2 * x + 1) + src.at<float>(2 * y + 1, 2 * x) + src.at<float>(2 * y + 1, 2 * x + 1)) * 0.5;
+				dst.at<float>(y,          x + width) = (src.at<float>(2 * y, 2 * x) + src.at<float>(2 * y + 1, 2 * x) - src.at<float>(2 * y, 2 * x + 1) - src.at<float>(2 * y + 1, 2 * x + 1)) * 0.5;
+				dst.at<float>(y + height, x)         = (src.at<float>(2 * y, 2 * x) + src.at<float>(2 * y, 2 * x + 1) - src.at<float>(2 * y + 1, 2 * x) - src.at<float>(2 * y + 1, 2 * x + 1)) * 0.5;
+				dst.at<float>(y + height, x + width) = (src.at<float>(2 * y, 2 * x) - src.at<float>(2 * y, 2 * x + 1) - src.at<float>(2 * y + 1, 2 * x) + src.at<float>(2 * y + 1, 2 * x + 1)) * 0.5;
+			}
+		}
+	};
+
+	auto inverse = [](const Mat& src, Mat& dst)
+	{
+		auto width  = src.cols / 2;
+		auto height = src.rows / 2;
+
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				auto c  = src.at<float>(y,          x);
+				auto dh = src.at<float>(y,          x + width);
+				auto dv = src.at<float>(y + height, x);
+				auto dd = src.at<float>(y + height, x + width);
+
+				dst.at<float>(y * 2,     x * 2)     = 0.5 * (c + dh + dv + dd);
+				dst.at<float>(y * 2,     x * 2 + 1) = 0.5 * (c - dh + dv - dd);
+				dst.at<float>(y * 2 + 1, x * 2)     = 0.5 * (c + dh - dv - dd);
+				dst.at<float>(y * 2 + 1, x * 2 + 1) = 0.5 * (c - dh - dv + dd);
+			}
+		}
+	};
+
+	auto measure = [&](const std::function<void()>& body)
+	{
+		auto start = getTickCount();
+
+		for (int i = 0; i < runs; i++)
+		{
+			body();
+		}
+
+		return (getTickCount() - start) / getTickFrequency() * 1e3 / runs;
+	};
+
+	auto old_fwd = measure([&] { forward(plane, haar1); });
+	auto new_fwd = measure([&] { cvHaarWavelet(plane, haar2); });
+	auto old_inv = measure([&] { inverse(haar1, recon1); });
+	auto new_inv = measure([&] { cvInvHaarWavelet(haar2, recon2); });
+
+	auto error = 0.f;
+
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			error = max(error, abs(haar1.at<float>(y, x) - haar2.at<float>(y, x)));
+			error = max(error, abs(recon2.at<float>(y, x) - plane.at<float>(y, x)));
+		}
+	}
+
+	cout << endl
+		 << "  Per-pixel forward: " << Format::White << Format::Bold << setw(8) << fixed << setprecision(2) << old_fwd << " ms" << Format::Normal << Format::Default << endl
+		 << "  Lifting forward:   " << Format::White << Format::Bold << setw(8) << fixed << setprecision(2) << new_fwd << " ms" << Format::Normal << Format::Default << " (" << old_fwd / new_fwd << "x)" << endl
+		 << "  Per-pixel inverse: " << Format::White << Format::Bold << setw(8) << fixed << setprecision(2) << old_inv << " ms" << Format::Normal << Format::Default << endl
+		 << "  Lifting inverse:   " << Format::White << Format::Bold << setw(8) << fixed << setprecision(2) << new_inv << " ms" << Format::Normal << Format::Default << " (" << old_inv / new_inv << "x)" << endl
+		 << "  Maximum deviation: " << Format::White << Format::Bold << scientific << setprecision(2) << error << Format::Normal << Format::Default << endl << endl;
+
+	cout.unsetf(ios::floatfield);
+}
+
+/*!
+ * Benchmarks the bit-plane LSB kernels against per-sample embedding and extraction.
+ */
+void bench_lsb()
+{
+	const auto size = 4096 * 4096 * 3;
+	const auto runs = 10;
+
+	Mat samples(1, size, CV_8U), stego1(1, size, CV_8U), stego2(1, size, CV_8U);
+	randu(samples, 0, 256);
+
+	string payload(size / 8, 0), text1(size / 8, 0), text2(size / 8, 0);
+
+	for (auto& c : payload)
+	{
+		c = char(rand());
+	}
+
+	auto src  = samples.ptr<uchar>();
+	auto bits = reinterpret_cast<const uchar*>(payload.data());
+
+	auto measure = [&](const std::function<void()>& body)
+	{
+		auto start = getTickCount();
+
+		for (int i = 0; i < runs; i++)
+		{
+			body();
+		}
+
+		return (getTickCount() - start) / getTickFrequency() * 1e3 / runs;
+	};
+
+	auto old_emb = measure([&]
+	{
+		auto dst = stego1.ptr<uchar>();
+
+		for (int b = 0; b < size; b++)
+		{
+			dst[b] = (src[b] & 254) | (bits[b / 8] & 1 << b % 8) >> b % 8;
+		}
+	});
+
+	auto new_emb = measure([&] { lsb_embed_bits(src, stego2.ptr<uchar>(), bits, 0, size); });
+
+	auto old_ext = measure([&]
+	{
+		auto dst = stego1.ptr<uchar>();
+
+		fill(text1.begin(), text1.end(), 0);
+
+		for (int b = 0; b < size; b++)
+		{
+			text1[b / 8] |= (dst[b] & 1) << b % 8;
+		}
+	});
+
+	auto new_ext = measure([&]
+	{
+		fill(text2.begin(), text2.end(), 0);
+		lsb_extract_bits(stego2.ptr<uchar>(), reinterpret_cast<uchar*>(&text2[0]), 0, size);
+	});
+
+	auto match = memcmp(stego1.ptr(), stego2.ptr(), size) == 0 && text1 == payload && text2 == payload;
+
+	cout << endl
+		 << "  Per-sample embed:   " << Format::White << Format::Bold << setw(8) << fixed << setprecision(2) << old_emb << " ms" << Format::Normal << Format::Default << endl
+		 << "  Bit-plane embed:    " << Format::White << Format::Bold << setw(8) << fixed << setprecision(2) << new_emb << " ms" << Format::Normal << Format::Default << " (" << old_emb / new_emb << "x)" << endl
+		 << "  Per-sample extract: " << Format::White << Format::Bold << setw(8) << fixed << setprecision(2) << old_ext << " ms" << Format::Normal << Format::Default << endl
+		 << "  Bit-plane extract:  " << Format::White << Format::Bold << setw(8) << fixed << setprecision(2) << new_ext << " ms" << Format::Normal << Format::Default << " (" << old_ext / new_ext << "x)" << endl
+		 << "  Outputs match:      " << (match ? Format::Green : Format::Red) << Format::Bold << (match ? "yes" : "no") << Format::Normal << Format::Default << endl << endl;
+
+	cout.unsetf(ios::floatfield);
+}
+
 /*!
  * Prompts the user for a selection from the available options.
  *
@@ -346,6 +835,158 @@ void select_channel(int& channel)
 	}
 }
 
+/*!
+ * Translates the JPEG component parameter value into a string.
+ *
+ * \param component Parameter value to translate.
+ *
+ * \return Translated value.
+ */
+string component_to_string(int component)
+{
+	switch (component)
+	{
+	case 0:  return "Encode All Components";
+	case 1:  return "Encode Luma Component";
+	case 2:  return "Encode Blue Chroma Component";
+	case 3:  return "Encode Red Chroma Component";
+	default: return "Unknown Mode " + to_string(component);
+	}
+}
+
+/*!
+ * Prompts the user to select a JPEG component.
+ *
+ * \param component Component variable to manipulate.
+ */
+void select_component(int& component)
+{
+	switch (show_menu("Components", {
+		{ 'a', "Encode All Components" },
+		{ 'y', "Encode Luma Component" },
+		{ 'u', "Encode Blue Chroma Component" },
+		{ 'v', "Encode Red Chroma Component" },
+		{ 'b', "Back to Main Menu" }
+	}))
+	{
+	case 'a': component = 0; break;
+	case 'y': component = 1; break;
+	case 'u': component = 2; break;
+	case 'v': component = 3; break;
+	}
+}
+
+/*!
+ * Translates a DCT_ORDER_* constant into a string.
+ *
+ * \param order Constant value to translate.
+ *
+ * \return Translated value.
+ */
+string order_to_string(int order)
+{
+	switch (order)
+	{
+	case DCT_ORDER_ROWS:    return "Row by Row";
+	case DCT_ORDER_COLUMNS: return "Column by Column (Legacy)";
+	default:                return "Unknown Order " + to_string(order);
+	}
+}
+
+/*!
+ * Prompts the user to select a block traversal order.
+ *
+ * \param order Order variable to manipulate.
+ */
+void select_order(int& order)
+{
+	switch (show_menu("Block Order", {
+		{ 'r', "Row by Row" },
+		{ 'c', "Column by Column (Legacy)" },
+		{ 'b', "Back to Main Menu" }
+	}))
+	{
+	case 'r': order = DCT_ORDER_ROWS;    break;
+	case 'c': order = DCT_ORDER_COLUMNS; break;
+	}
+}
+
+/*!
+ * Translates the DWT extraction mode into a string.
+ *
+ * \param blind Value indicating whether the original image is not needed.
+ *
+ * \return Translated value.
+ */
+string extraction_to_string(bool blind)
+{
+	return blind ? "Blind" : "Original Required";
+}
+
+/*!
+ * Prompts the user to select a DWT extraction mode.
+ *
+ * \param blind Mode variable to manipulate.
+ */
+void select_extraction(bool& blind)
+{
+	switch (show_menu("Extraction Mode", {
+		{ 'o', "Original Required" },
+		{ 'n', "Blind" },
+		{ 'b', "Back to Main Menu" }
+	}))
+	{
+	case 'o': blind = false; break;
+	case 'n': blind = true;  break;
+	}
+}
+
+/*!
+ * Translates the key of the embedding order into a string.
+ *
+ * \param key Key of the pseudo-random embedding order.
+ *
+ * \return Translated value.
+ */
+string key_to_string(const string& key)
+{
+	return key.empty() ? "None (Raster Order)" : key;
+}
+
+/*!
+ * Converts the matrix embedding setting to its string representation.
+ *
+ * \param matrix Bits hidden per group of samples, or 0 for none.
+ *
+ * \return String representation.
+ */
+string matrix_to_string(int matrix)
+{
+	if (matrix == 0)
+	{
+		return "None (1 Bit per Sample)";
+	}
+
+	return to_string(matrix) + " Bits per " + to_string((1 << matrix) - 1) + " Samples";
+}
+
+/*!
+ * Converts the extraction output to its string representation.
+ *
+ * \param output Path to the output file, "-" for the standard output, or empty for the console.
+ *
+ * \return String representation.
+ */
+string output_to_string(const string& output)
+{
+	if (output.empty())
+	{
+		return "None (Print as Text)";
+	}
+
+	return output == "-" ? "Standard Output" : output;
+}
+
 /*!
  * Prompts the user to provide a string value.
  *
@@ -451,14 +1092,254 @@ void prompt_double(const string& title, double& value, double min = DBL_MIN, dou
 }
 
 /*!
- * Runs the least significant bit method.
+ * Runs the least significant bit method.
+ *
+ * \param input Path to original image.
+ * \param secret Path to the data to be hidden.
+ * \param store Storage mode.
+ * \param channel Channels to encode.
+ * \param bits Bits per sample, when all channels are used.
+ * \param key Key of the pseudo-random embedding order, or empty for raster order.
+ * \param matrix Bits hidden per group of samples with matrix embedding, or 0 to hide a bit per sample.
+ */
+void do_lsb(const string& input, const string& secret, int store, int channel, int bits, const string& key, int matrix)
+{
+	if (matrix > 0 && (channel != 0 || bits != 1 || !key.empty()))
+	{
+		cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Matrix embedding requires all channels with 1 bit per sample in raster order." << endl << endl;
+		return;
+	}
+
+	// the data is hidden straight from a mapping of its file, without being read into a string
+	Payload data;
+
+	if (!data.map(secret))
+	{
+		cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to open data file from '" << secret << "'." << endl << endl;
+		return;
+	}
+
+	// the length is stored in the header as an int, so larger data could not be extracted
+	if (data.size() > TLV_MAX_LENGTH)
+	{
+		cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Data file '" << secret << "' is larger than " << TLV_MAX_LENGTH << " bytes." << endl << endl;
+		return;
+	}
+
+	// uncompressed rasters are altered through a memory mapping, without decoding the image
+	if (channel == 0 && bits == 1 && key.empty() && matrix == 0 && lsb_mapped_supported(input))
+	{
+		auto altered = remove_extension(input) + ".lsb" + input.substr(remove_extension(input).length());
+
+		if (!encode_lsb_mapped(input, altered, encode_tlv(data), store))
+		{
+			cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to write altered image to '" << altered << "'." << endl << endl;
+			return;
+		}
+
+		cout << endl << "  " << Format::Green << Format::Bold << "Success:" << Format::Normal << Format::Default << " Altered image written to '" << altered << "'." << endl;
+
+		print_debug(data, [&](ostream& out) { decode_lsb_mapped_tlv_to(altered, out); });
+		return;
+	}
+
+	// 16-bit and grayscale images are kept as they are when all channels are used
+	auto img = imread(input, channel == 0 ? IMREAD_ANYDEPTH | IMREAD_ANYCOLOR : IMREAD_COLOR);
+
+	if (!img.data)
+	{
+		cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to open input image from '" << input << "'." << endl << endl;
+		return;
+	}
+
+	show_image(img, "Original");
+
+	// the original is not needed anymore, so it is altered in place
+	if (matrix > 0)
+	{
+		auto changes = encode_lsb_matrix_inplace(img, encode_tlv(data), store, matrix);
+
+		if (changes < 0)
+		{
+			cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Unsupported image type for matrix embedding." << endl << endl;
+			return;
+		}
+
+		cout << endl << "  Changed " << changes << " samples with matrix embedding." << endl;
+	}
+	else if (channel == 0)
+	{
+		if (encode_lsb_inplace(img, encode_tlv(data), store, bits, key) < 0)
+		{
+			cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Unsupported image type for " << bits << " bits per sample." << endl << endl;
+			return;
+		}
+	}
+	else
+	{
+		encode_lsb_alt_inplace(img, encode_tlv(data), store, key);
+	}
+
+	auto altered = remove_extension(input) + ".lsb.png";
+
+	imwrite(altered, img);
+
+	cout << endl << "  " << Format::Green << Format::Bold << "Success:" << Format::Normal << Format::Default << " Altered image written to '" << altered << "'." << endl;
+
+	auto stego = imread(altered, channel == 0 ? IMREAD_ANYDEPTH | IMREAD_ANYCOLOR : IMREAD_COLOR);
+
+	// the extracted data is compared with the original as it is streamed, instead of being held in a string
+	print_debug(data, [&](ostream& out)
+	{
+		if (matrix > 0)
+		{
+			decode_tlv_lazy_to([&](int64_t offset, int64_t length) { return decode_lsb_matrix_range(stego, offset, length, matrix); }, out);
+		}
+		else if (channel == 0)
+		{
+			decode_lsb_tlv_to(stego, out, bits, key);
+		}
+		else
+		{
+			decode_tlv_lazy_to([&](int64_t offset, int64_t length) { return decode_lsb_alt_range(stego, offset, length, key); }, out);
+		}
+	});
+
+	show_image(stego, "Altered");
+}
+
+/*!
+ * Runs the least significant bit extraction method.
+ *
+ * \param altered Path to the altered image.
+ * \param channel Channels to decode.
+ * \param bits Bits per sample, when all channels are used.
+ * \param key Key of the pseudo-random embedding order, or empty for raster order.
+ * \param output Path to write the extracted data to, "-" for the standard output, or empty to print it as text.
+ * \param matrix Bits hidden per group of samples with matrix embedding, or 0 if a bit was hidden per sample.
+ */
+void read_lsb(const string& altered, int channel, int bits, const string& key, const string& output, int matrix)
+{
+	// uncompressed rasters are read through a memory mapping, without decoding the image
+	auto mapped = channel == 0 && bits == 1 && key.empty() && matrix == 0 && lsb_mapped_supported(altered);
+
+	Mat stego;
+
+	if (!mapped)
+	{
+		stego = imread(altered, channel == 0 ? IMREAD_ANYDEPTH | IMREAD_ANYCOLOR : IMREAD_COLOR);
+
+		if (!stego.data)
+		{
+			cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to open altered image from '" << altered << "'." << endl << endl;
+			return;
+		}
+	}
+
+	// the data is written as is in chunks when an output was specified, so binary data is kept intact
+	if (!output.empty())
+	{
+		ofstream file;
+
+		if (output == "-")
+		{
+#if _WIN32
+			_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		}
+		else
+		{
+			file.open(output, ios::binary | ios::trunc);
+
+			if (!file)
+			{
+				cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to open output file '" << output << "'." << endl << endl;
+				return;
+			}
+		}
+
+		auto& out = output == "-" ? static_cast<ostream&>(cout) : file;
+
+		int64_t written;
+
+		if (mapped)
+		{
+			written = decode_lsb_mapped_tlv_to(altered, out);
+		}
+		else if (matrix > 0)
+		{
+			written = decode_tlv_lazy_to([&](int64_t offset, int64_t length) { return decode_lsb_matrix_range(stego, offset, length, matrix); }, out);
+		}
+		else if (channel == 0)
+		{
+			written = decode_lsb_tlv_to(stego, out, bits, key);
+		}
+		else
+		{
+			written = decode_tlv_lazy_to([&](int64_t offset, int64_t length) { return decode_lsb_alt_range(stego, offset, length, key); }, out);
+		}
+
+		out.flush();
+
+#if _WIN32
+		if (output == "-")
+		{
+			_setmode(_fileno(stdout), _O_TEXT);
+		}
+#endif
+
+		if (written < 0 || !out)
+		{
+			cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to extract data from '" << altered << "'." << endl << endl;
+			return;
+		}
+
+		if (output != "-")
+		{
+			cout << endl << "  " << Format::Green << Format::Bold << "Success:" << Format::Normal << Format::Default << " Extracted " << written << " bytes to '" << output << "'." << endl << endl;
+		}
+
+		return;
+	}
+
+	string text;
+
+	if (mapped)
+	{
+		text = decode_lsb_mapped_tlv(altered);
+	}
+	else if (matrix > 0)
+	{
+		text = decode_lsb_matrix_tlv(stego, matrix);
+	}
+	else if (channel == 0)
+	{
+		text = decode_lsb_tlv(stego, bits, key);
+	}
+	else
+	{
+		text = decode_lsb_alt_tlv(stego, key);
+	}
+
+	text = clean(text);
+
+	cout << endl << "  Extracted:" << endl << endl << Format::White << Format::Bold << text << Format::Normal << Format::Default << endl << endl;
+}
+
+/*!
+ * Runs the discrete cosine transformation method.
  *
  * \param input Path to original image.
  * \param secret Path to the data to be hidden.
  * \param store Storage mode.
  * \param channel Channels to encode.
+ * \param persistence Persistence value.
+ * \param compression JPEG compression percentage.
+ * \param order Block traversal order.
+ * \param pairs Bits hidden per block.
+ * \param key Key of the pseudo-random embedding order, or empty for raster order.
  */
-void do_lsb(const string& input, const string& secret, int store, int channel)
+void do_dct(const string& input, const string& secret, int store, int channel, int persistence, int compression, int order, int pairs, const string& key)
 {
 	auto img = imread(input);
 
@@ -476,16 +1357,16 @@ void do_lsb(const string& input, const string& secret, int store, int channel)
 
 	if (channel == 0)
 	{
-		stego = encode_lsb(img, encode_tlv(data), store);
+		stego = encode_dct(img, data, store, vector<int> { 0, 1, 2 }, persistence, order, pairs, key);
 	}
 	else
 	{
-		stego = encode_lsb_alt(img, encode_tlv(data), store);
+		stego = encode_dct(img, data, store, channel - 1, persistence, order, pairs, key);
 	}
 
-	auto altered = remove_extension(input) + ".lsb.png";
+	auto altered = remove_extension(input) + ".dct.jpg";
 
-	imwrite(altered, stego);
+	imwrite(altered, stego, vector<int> { CV_IMWRITE_JPEG_QUALITY, compression });
 
 	cout << endl << "  " << Format::Green << Format::Bold << "Success:" << Format::Normal << Format::Default << " Altered image written to '" << altered << "'." << endl;
 
@@ -495,11 +1376,16 @@ void do_lsb(const string& input, const string& secret, int store, int channel)
 
 	if (channel == 0)
 	{
-		output = decode_tlv(decode_lsb(stego));
+		output = repair(vector<string>
+			{
+				decode_dct(stego, 0, order, pairs, key),
+				decode_dct(stego, 1, order, pairs, key),
+				decode_dct(stego, 2, order, pairs, key)
+			});
 	}
 	else
 	{
-		output = decode_tlv(decode_lsb_alt(stego));
+		output = decode_dct(stego, channel - 1, order, pairs, key);
 	}
 
 	print_debug(data, output);
@@ -508,12 +1394,15 @@ void do_lsb(const string& input, const string& secret, int store, int channel)
 }
 
 /*!
- * Runs the least significant bit extraction method.
+ * Runs the discrete cosine transformation extraction method.
  *
  * \param altered Path to the altered image.
  * \param channel Channels to decode.
+ * \param order Block traversal order.
+ * \param pairs Bits hidden per block.
+ * \param key Key of the pseudo-random embedding order, or empty for raster order.
  */
-void read_lsb(const string& altered, int channel)
+void read_dct(const string& altered, int channel, int order, int pairs, const string& key)
 {
 	auto stego = imread(altered);
 
@@ -527,11 +1416,16 @@ void read_lsb(const string& altered, int channel)
 
 	if (channel == 0)
 	{
-		output = decode_tlv(decode_lsb(stego));
+		output = repair(vector<string>
+			{
+				decode_dct(stego, 0, order, pairs, key),
+				decode_dct(stego, 1, order, pairs, key),
+				decode_dct(stego, 2, order, pairs, key)
+			});
 	}
 	else
 	{
-		output = decode_tlv(decode_lsb_alt(stego));
+		output = decode_dct(stego, channel - 1, order, pairs, key);
 	}
 
 	output = clean(output);
@@ -540,16 +1434,16 @@ void read_lsb(const string& altered, int channel)
 }
 
 /*!
- * Runs the discrete cosine transformation method.
+ * Runs the quantized JPEG coefficient method.
  *
- * \param input Path to original image.
+ * \param input Path to original JPEG image.
  * \param secret Path to the data to be hidden.
  * \param store Storage mode.
- * \param channel Channels to encode.
+ * \param component Components to encode.
  * \param persistence Persistence value.
- * \param compression JPEG compression percentage.
+ * \param order Block traversal order.
  */
-void do_dct(const string& input, const string& secret, int store, int channel, int persistence, int compression)
+void do_dct_jpeg(const string& input, const string& secret, int store, int component, int persistence, int order)
 {
 	auto img = imread(input);
 
@@ -561,80 +1455,69 @@ void do_dct(const string& input, const string& secret, int store, int channel, i
 
 	show_image(img, "Original");
 
-	auto data = read_file(secret);
+	auto data    = read_file(secret);
+	auto altered = remove_extension(input) + ".coef.jpg";
 
-	Mat stego;
+	auto components = component == 0 ? vector<int> { 0, 1, 2 } : vector<int> { component - 1 };
 
-	if (channel == 0)
-	{
-		stego = encode_dct(img,   data, store, 0, persistence);
-		stego = encode_dct(stego, data, store, 1, persistence);
-		stego = encode_dct(stego, data, store, 2, persistence);
-	}
-	else
+	if (!encode_dct_jpeg(input, altered, data, store, components, persistence, order))
 	{
-		stego = encode_dct(img, data, store, channel - 1, persistence);
+		cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to transcode JPEG coefficients from '" << input << "' to '" << altered << "'." << endl << endl;
+		return;
 	}
 
-	auto altered = remove_extension(input) + ".dct.jpg";
-
-	imwrite(altered, stego, vector<int> { CV_IMWRITE_JPEG_QUALITY, compression });
-
 	cout << endl << "  " << Format::Green << Format::Bold << "Success:" << Format::Normal << Format::Default << " Altered image written to '" << altered << "'." << endl;
 
-	stego = imread(altered);
-
 	string output;
 
-	if (channel == 0)
+	if (component == 0)
 	{
 		output = repair(vector<string>
 			{
-				decode_dct(stego, 0),
-				decode_dct(stego, 1),
-				decode_dct(stego, 2)
+				decode_dct_jpeg(altered, 0, order),
+				decode_dct_jpeg(altered, 1, order),
+				decode_dct_jpeg(altered, 2, order)
 			});
 	}
 	else
 	{
-		output = decode_dct(stego, channel - 1);
+		output = decode_dct_jpeg(altered, component - 1, order);
 	}
 
 	print_debug(data, output);
 
-	show_image(stego, "Altered");
+	show_image(imread(altered), "Altered");
 }
 
 /*!
- * Runs the discrete cosine transformation extraction method.
+ * Runs the quantized JPEG coefficient extraction method.
  *
- * \param altered Path to the altered image.
- * \param channel Channels to decode.
+ * \param altered Path to the altered JPEG image.
+ * \param component Components to decode.
+ * \param order Block traversal order.
  */
-void read_dct(const string& altered, int channel)
+void read_dct_jpeg(const string& altered, int component, int order)
 {
-	auto stego = imread(altered);
-
-	if (!stego.data)
-	{
-		cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to open altered image from '" << altered << "'." << endl << endl;
-		return;
-	}
-
 	string output;
 
-	if (channel == 0)
+	if (component == 0)
 	{
 		output = repair(vector<string>
 			{
-				decode_dct(stego, 0),
-				decode_dct(stego, 1),
-				decode_dct(stego, 2)
+				decode_dct_jpeg(altered, 0, order),
+				decode_dct_jpeg(altered, 1, order),
+				decode_dct_jpeg(altered, 2, order)
 			});
 	}
 	else
 	{
-		output = decode_dct(stego, channel - 1);
+		output = decode_dct_jpeg(altered, component - 1, order);
+	}
+
+	if (output.empty())
+	{
+		cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to read JPEG coefficients from '" << altered << "'." << endl << endl;
+		return;
 	}
 
 	output = clean(output);
@@ -650,8 +1533,10 @@ void read_dct(const string& altered, int channel)
  * \param store Storage mode.
  * \param channel Channels to encode.
  * \param persistence Persistence value.
+ * \param order Block traversal order.
+ * \param pairs Bits hidden per block.
  */
-void do_dct_vid(const string& input, const string& secret, int store, int channel, int persistence)
+void do_dct_vid(const string& input, const string& secret, int store, int channel, int persistence, int order, int pairs)
 {
 	VideoCapture cap(input);
 
@@ -683,27 +1568,22 @@ void do_dct_vid(const string& input, const string& secret, int store, int channe
 
 	auto data = read_file(secret);
 
-	while (cap.grab())
+	// frames are decoded, altered and encoded concurrently, and shown as they are written
+	process_video(cap, wrt, [&](const Mat& frame, int64_t)
 	{
-		Mat frame;
-		cap.retrieve(frame);
-
-		imshow(title, frame);
-		waitKey(1);
-
 		if (channel == 0)
 		{
-			frame = encode_dct(frame, data, store, 0, persistence);
-			frame = encode_dct(frame, data, store, 1, persistence);
-			frame = encode_dct(frame, data, store, 2, persistence);
+			return encode_dct(frame, data, store, vector<int> { 0, 1, 2 }, persistence, order, pairs);
 		}
 		else
 		{
-			frame = encode_dct(frame, data, store, channel - 1, persistence);
+			return encode_dct(frame, data, store, channel - 1, persistence, order, pairs);
 		}
-
-		wrt.write(frame);
-	}
+	}, 0, 0, [&](const Mat& frame)
+	{
+		imshow(title, frame);
+		waitKey(1);
+	});
 
 	destroyWindow(title);
 
@@ -715,8 +1595,10 @@ void do_dct_vid(const string& input, const string& secret, int store, int channe
  *
  * \param altered Path to the altered video.
  * \param channel Channels to decode.
+ * \param order Block traversal order.
+ * \param pairs Bits hidden per block.
  */
-void read_dct_vid(const string& altered, int channel)
+void read_dct_vid(const string& altered, int channel, int order, int pairs)
 {
 	VideoCapture cap(altered);
 
@@ -734,26 +1616,28 @@ void read_dct_vid(const string& altered, int channel)
 	resizeWindow(title, 512, 288);
 	moveWindow(title, 50, 50);
 
-	vector<string> strings;
-
-	while (cap.grab())
+	// contiguous segments of the video are decoded in parallel, and the results are merged in frame order
+	auto results = process_video_segments<vector<string>>(altered, [&](const Mat& frame, int64_t)
 	{
-		Mat frame;
-		cap.retrieve(frame);
-
-		imshow(title, frame);
-		waitKey(1);
-
 		if (channel == 0)
 		{
-			strings.push_back(decode_dct(frame, 0));
-			strings.push_back(decode_dct(frame, 1));
-			strings.push_back(decode_dct(frame, 2));
+			return vector<string> { decode_dct(frame, 0, order, pairs), decode_dct(frame, 1, order, pairs), decode_dct(frame, 2, order, pairs) };
 		}
 		else
 		{
-			strings.push_back(decode_dct(frame, channel - 1));
+			return vector<string> { decode_dct(frame, channel - 1, order, pairs) };
 		}
+	}, 0, [&](const Mat& frame)
+	{
+		imshow(title, frame);
+		waitKey(1);
+	});
+
+	vector<string> strings;
+
+	for (auto& result : results)
+	{
+		strings.insert(strings.end(), result.begin(), result.end());
 	}
 
 	destroyWindow(title);
@@ -772,10 +1656,15 @@ void read_dct_vid(const string& altered, int channel)
  * \param secret Path to the data to be hidden.
  * \param store Storage mode.
  * \param channel Channels to encode.
- * \param alpha Encoding intensity.
+ * \param alpha Encoding intensity of the diagonal filter.
  * \param compression JPEG compression percentage.
+ * \param blind Hide the data for extraction without the original image.
+ * \param levels Number of decomposition levels.
+ * \param horizontal Encoding intensity of the horizontal filter, or 0 to leave it unused.
+ * \param vertical Encoding intensity of the vertical filter, or 0 to leave it unused.
+ * \param key Key of the pseudo-random embedding order, or empty for raster order, only used with the diagonal filter alone.
  */
-void do_dwt(const string& input, const string& secret, int store, int channel, double alpha, int compression)
+void do_dwt(const string& input, const string& secret, int store, int channel, double alpha, int compression, bool blind, int levels, double horizontal, double vertical, const string& key)
 {
 	auto img = imread(input);
 
@@ -791,15 +1680,28 @@ void do_dwt(const string& input, const string& secret, int store, int channel, d
 
 	Mat stego;
 
+	auto multi     = levels > 1 || horizontal > 0 || vertical > 0;
+	auto strengths = Vec3f(float(horizontal), float(vertical), float(alpha));
+
+	auto encode = [&](const Mat& src, int ch)
+	{
+		if (multi)
+		{
+			return blind ? encode_dwt_multi_blind(src, data, store, ch, levels, strengths) : encode_dwt_multi(src, data, store, ch, levels, strengths);
+		}
+
+		return blind ? encode_dwt_blind(src, data, store, ch, alpha, key) : encode_dwt(src, data, store, ch, alpha, key);
+	};
+
 	if (channel == 0)
 	{
-		stego = encode_dwt(img,   data, store, 0, alpha);
-		stego = encode_dwt(stego, data, store, 1, alpha);
-		stego = encode_dwt(stego, data, store, 2, alpha);
+		stego = encode(img,   0);
+		stego = encode(stego, 1);
+		stego = encode(stego, 2);
 	}
 	else
 	{
-		stego = encode_dwt(img, data, store, channel - 1, alpha);
+		stego = encode(img, channel - 1);
 	}
 
 	auto altered = remove_extension(input) + ".dwt.jpg";
@@ -810,20 +1712,30 @@ void do_dwt(const string& input, const string& secret, int store, int channel, d
 
 	stego = imread(altered);
 
+	auto decode = [&](int ch)
+	{
+		if (multi)
+		{
+			return blind ? decode_dwt_multi_blind(stego, ch, levels, strengths) : decode_dwt_multi(img, stego, ch, levels, strengths);
+		}
+
+		return blind ? decode_dwt_blind(stego, ch, key) : decode_dwt(img, stego, ch, key);
+	};
+
 	string output;
 
 	if (channel == 0)
 	{
 		output = repair(vector<string>
 			{
-				decode_dwt(img, stego, 0),
-				decode_dwt(img, stego, 1),
-				decode_dwt(img, stego, 2)
+				decode(0),
+				decode(1),
+				decode(2)
 			});
 	}
 	else
 	{
-		output = decode_dwt(img, stego, channel - 1);
+		output = decode(channel - 1);
 	}
 
 	print_debug(data, output);
@@ -831,44 +1743,148 @@ void do_dwt(const string& input, const string& secret, int store, int channel, d
 	show_image(stego, "Altered");
 }
 
+/*!
+ * Runs the discrete wavelet transformation extraction method on multiple filters and levels.
+ *
+ * \param input Path to original image.
+ * \param stego Altered image.
+ * \param channel Channels to decode.
+ * \param levels Number of decomposition levels.
+ * \param strengths Encoding intensities of the horizontal, vertical and diagonal filters.
+ */
+void read_dwt_multi(const string& input, const Mat& stego, int channel, int levels, const Vec3f& strengths)
+{
+	auto img = imread(input);
+
+	if (!img.data)
+	{
+		cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to open original image from '" << input << "'." << endl << endl;
+		return;
+	}
+
+	string output;
+
+	if (channel == 0)
+	{
+		output = repair(vector<string>
+			{
+				decode_dwt_multi(img, stego, 0, levels, strengths),
+				decode_dwt_multi(img, stego, 1, levels, strengths),
+				decode_dwt_multi(img, stego, 2, levels, strengths)
+			});
+	}
+	else
+	{
+		output = decode_dwt_multi(img, stego, channel - 1, levels, strengths);
+	}
+
+	output = clean(output);
+
+	cout << endl << "  Extracted:" << endl << endl << Format::White << Format::Bold << output << Format::Normal << Format::Default << endl << endl;
+}
+
 /*!
  * Runs the discrete wavelet transformation extraction method.
+ * The diagonal filter of the original image is cached between extractions.
  *
  * \param input Path to original image.
  * \param altered Path to the altered image.
  * \param channel Channels to decode.
+ * \param levels Number of decomposition levels.
+ * \param strengths Encoding intensities of the horizontal, vertical and diagonal filters.
+ * \param key Key of the pseudo-random embedding order, or empty for raster order.
  */
-void read_dwt(const string& input, const string& altered, int channel)
+void read_dwt(const string& input, const string& altered, int channel, int levels, const Vec3f& strengths, const string& key)
 {
-	auto img   = imread(input);
 	auto stego = imread(altered);
 
-	if (!img.data)
+	if (!stego.data)
+	{
+		cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to open altered image from '" << altered << "'." << endl << endl;
+		return;
+	}
+
+	if (levels > 1 || strengths[0] > 0 || strengths[1] > 0)
+	{
+		read_dwt_multi(input, stego, channel, levels, strengths);
+		return;
+	}
+
+	Mat img;
+	auto id   = dwt_cache_key(input);
+	auto load = [&]
+	{
+		if (!img.data)
+		{
+			img = imread(input);
+		}
+
+		return img;
+	};
+
+	if (!id || !dwt_default_cache().diagonal(id, channel == 0 ? 0 : channel - 1, load))
 	{
 		cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to open original image from '" << input << "'." << endl << endl;
 		return;
 	}
 
+	string output;
+
+	if (channel == 0)
+	{
+		output = repair(vector<string>
+			{
+				decode_dwt_cached(dwt_default_cache(), id, load, stego, 0, key),
+				decode_dwt_cached(dwt_default_cache(), id, load, stego, 1, key),
+				decode_dwt_cached(dwt_default_cache(), id, load, stego, 2, key)
+			});
+	}
+	else
+	{
+		output = decode_dwt_cached(dwt_default_cache(), id, load, stego, channel - 1, key);
+	}
+
+	output = clean(output);
+
+	cout << endl << "  Extracted:" << endl << endl << Format::White << Format::Bold << output << Format::Normal << Format::Default << endl << endl;
+}
+
+/*!
+ * Runs the blind discrete wavelet transformation extraction method.
+ *
+ * \param altered Path to the altered image.
+ * \param channel Channels to decode.
+ * \param levels Number of decomposition levels.
+ * \param strengths Encoding intensities of the horizontal, vertical and diagonal filters.
+ * \param key Key of the pseudo-random embedding order, or empty for raster order.
+ */
+void read_dwt_blind(const string& altered, int channel, int levels, const Vec3f& strengths, const string& key)
+{
+	auto stego = imread(altered);
+
 	if (!stego.data)
 	{
 		cerr << endl << "  " << Format::Red << Format::Bold << "Error:" << Format::Normal << Format::Default << " Failed to open altered image from '" << altered << "'." << endl << endl;
 		return;
 	}
 
+	auto multi  = levels > 1 || strengths[0] > 0 || strengths[1] > 0;
+	auto decode = [&](int ch) { return multi ? decode_dwt_multi_blind(stego, ch, levels, strengths) : decode_dwt_blind(stego, ch, key); };
+
 	string output;
 
 	if (channel == 0)
 	{
 		output = repair(vector<string>
 			{
-				decode_dwt(img, stego, 0),
-				decode_dwt(img, stego, 1),
-				decode_dwt(img, stego, 2)
+				decode(0),
+				decode(1),
+				decode(2)
 			});
 	}
 	else
 	{
-		output = decode_dwt(img, stego, channel - 1);
+		output = decode(channel - 1);
 	}
 
 	output = clean(output);
@@ -911,6 +1927,7 @@ main:
 			{ 'l', "Least Significant Bit" },
 			{ 'c', "Discrete Cosine Transformation" },
 			{ 'w', "Discrete Wavelet Transformation" },
+			{ 'j', "Quantized JPEG Coefficients" },
 			{ 'b', "Back to Main Menu" }
 		}))
 		{
@@ -918,7 +1935,8 @@ main:
 		{
 			string input  = "test/img.png";
 			string secret = "test/test.txt";
-			auto store = STORE_ONCE, channel = 0;
+			string key, output;
+			auto store = STORE_ONCE, channel = 0, bits = 1, matrix = 0;
 
 		mnlsb:
 			switch (show_menu("LSB Configuration", {
@@ -926,6 +1944,10 @@ main:
 				{ 'd', "Data File:     " + secret },
 				{ 's', "Storage Mode:  " + store_to_string(store) },
 				{ 'c', "Channel Usage: " + channel_to_string(channel) },
+				{ 'n', "Bits/Sample:   " + to_string(bits) },
+				{ 'k', "Order Key:     " + key_to_string(key) },
+				{ 'm', "Matrix Coding: " + matrix_to_string(matrix) },
+				{ 'o', "Output File:   " + output_to_string(output) },
 				{ 'a', "Perform Steganography" },
 				{ 'x', "Perform Extraction" },
 				{ 'b', "Back to Main Menu" }
@@ -947,13 +1969,29 @@ main:
 				select_channel(channel);
 				goto mnlsb;
 
+			case 'n':
+				prompt_int("Bits per Sample", bits, 1, 4);
+				goto mnlsb;
+
+			case 'k':
+				prompt_string("Order Key", key);
+				goto mnlsb;
+
+			case 'm':
+				prompt_int("Matrix Bits (0 to Disable)", matrix, 0, LSB_MATRIX_MAX);
+				goto mnlsb;
+
+			case 'o':
+				prompt_string("Output File", output);
+				goto mnlsb;
+
 			case 'a':
-				do_lsb(input, secret, store, channel);
+				do_lsb(input, secret, store, channel, bits, key, matrix);
 				cvWaitKey();
 				break;
 
 			case 'x':
-				read_lsb(input, channel);
+				read_lsb(input, channel, bits, key, output, matrix);
 				system("pause");
 				break;
 
@@ -967,7 +2005,8 @@ main:
 		{
 			string input  = "test/lena.jpg";
 			string secret = "test/test.txt";
-			auto store = STORE_FULL, channel = 0, persistence = 30, compression = 80;
+			string key;
+			auto store = STORE_FULL, channel = 0, persistence = 30, compression = 80, order = DCT_ORDER_ROWS, pairs = 1;
 
 		mndct:
 			switch (show_menu("DCT Configuration", {
@@ -975,6 +2014,9 @@ main:
 				{ 'd', "Data File:     " + secret },
 				{ 's', "Storage Mode:  " + store_to_string(store) },
 				{ 'c', "Channel Usage: " + channel_to_string(channel) },
+				{ 'o', "Block Order:   " + order_to_string(order) },
+				{ 'n', "Bits/Block:    " + to_string(pairs) },
+				{ 'k', "Order Key:     " + key_to_string(key) },
 				{ 'p', "Persistence:   " + to_string(persistence) + "%" },
 				{ 'j', "Compression:   " + to_string(compression) + "%" },
 				{ 'a', "Perform Steganography" },
@@ -998,6 +2040,18 @@ main:
 				select_channel(channel);
 				goto mndct;
 
+			case 'o':
+				select_order(order);
+				goto mndct;
+
+			case 'n':
+				prompt_int("Bits per Block", pairs, 1, DCT_MAX_PAIRS);
+				goto mndct;
+
+			case 'k':
+				prompt_string("Order Key", key);
+				goto mndct;
+
 			case 'p':
 				prompt_int("Persistence Percentage", persistence, 0, 100);
 				goto mndct;
@@ -1007,12 +2061,71 @@ main:
 				goto mndct;
 
 			case 'a':
-				do_dct(input, secret, store, channel, persistence, compression);
+				do_dct(input, secret, store, channel, persistence, compression, order, pairs, key);
+				cvWaitKey();
+				break;
+
+			case 'x':
+				read_dct(input, channel, order, pairs, key);
+				system("pause");
+				break;
+
+			case 'b':
+				goto main;
+			}
+		}
+		break;
+
+		case 'j':
+		{
+			string input  = "test/lena.jpg";
+			string secret = "test/test.txt";
+			auto store = STORE_FULL, component = 0, persistence = 30, order = DCT_ORDER_ROWS;
+
+		mnjpg:
+			switch (show_menu("JPEG Configuration", {
+				{ 'i', "Input File:    " + input },
+				{ 'd', "Data File:     " + secret },
+				{ 's', "Storage Mode:  " + store_to_string(store) },
+				{ 'c', "Components:    " + component_to_string(component) },
+				{ 'o', "Block Order:   " + order_to_string(order) },
+				{ 'p', "Persistence:   " + to_string(persistence) + "%" },
+				{ 'a', "Perform Steganography" },
+				{ 'x', "Perform Extraction" },
+				{ 'b', "Back to Main Menu" }
+			}, "ax"))
+			{
+			case 'i':
+				prompt_string("Input File", input, true);
+				goto mnjpg;
+
+			case 'd':
+				prompt_string("Data File", secret, true);
+				goto mnjpg;
+
+			case 's':
+				select_store(store);
+				goto mnjpg;
+
+			case 'c':
+				select_component(component);
+				goto mnjpg;
+
+			case 'o':
+				select_order(order);
+				goto mnjpg;
+
+			case 'p':
+				prompt_int("Persistence Percentage", persistence, 0, 100);
+				goto mnjpg;
+
+			case 'a':
+				do_dct_jpeg(input, secret, store, component, persistence, order);
 				cvWaitKey();
 				break;
 
 			case 'x':
-				read_dct(input, channel);
+				read_dct_jpeg(input, component, order);
 				system("pause");
 				break;
 
@@ -1026,8 +2139,10 @@ main:
 		{
 			string input  = "test/lena.jpg";
 			string secret = "test/test.txt";
-			auto store = STORE_FULL, channel = 0, compression = 90;
-			auto alpha = 0.1;
+			string key;
+			auto store = STORE_FULL, channel = 0, compression = 90, levels = 1;
+			auto alpha = 0.1, horizontal = 0.0, vertical = 0.0;
+			auto blind = false;
 
 		mndwt:
 			switch (show_menu("DWT Configuration", {
@@ -1035,7 +2150,12 @@ main:
 				{ 'd', "Data File:     " + secret },
 				{ 's', "Storage Mode:  " + store_to_string(store) },
 				{ 'c', "Channel Usage: " + channel_to_string(channel) },
+				{ 'e', "Extraction:    " + extraction_to_string(blind) },
 				{ 'p', "Intensity:     " + to_string(alpha) },
+				{ 'h', "Horizontal:    " + to_string(horizontal) },
+				{ 'v', "Vertical:      " + to_string(vertical) },
+				{ 'l', "Levels:        " + to_string(levels) },
+				{ 'k', "Order Key:     " + key_to_string(key) },
 				{ 'j', "Compression:   " + to_string(compression) + "%" },
 				{ 'a', "Perform Steganography" },
 				{ 'x', "Perform Extraction" },
@@ -1058,21 +2178,48 @@ main:
 				select_channel(channel);
 				goto mndwt;
 
+			case 'e':
+				select_extraction(blind);
+				goto mndwt;
+
 			case 'p':
 				prompt_double("Intensity Value", alpha, 0.01, 1);
 				goto mndwt;
 
+			case 'h':
+				prompt_double("Horizontal Intensity Value", horizontal, 0, 1);
+				goto mndwt;
+
+			case 'v':
+				prompt_double("Vertical Intensity Value", vertical, 0, 1);
+				goto mndwt;
+
+			case 'l':
+				prompt_int("Decomposition Levels", levels, 1, DWT_MAX_LEVELS);
+				goto mndwt;
+
+			case 'k':
+				prompt_string("Order Key", key);
+				goto mndwt;
+
 			case 'j':
 				prompt_int("JPEG Compression Percentage", compression, 0, 100);
 				goto mndwt;
 
 			case 'a':
-				do_dwt(input, secret, store, channel, alpha, compression);
+				do_dwt(input, secret, store, channel, alpha, compression, blind, levels, horizontal, vertical, key);
 				cvWaitKey();
 				break;
 
 			case 'x':
-				read_dwt(input, secret, channel);
+				if (blind)
+				{
+					read_dwt_blind(input, channel, levels, Vec3f(float(horizontal), float(vertical), float(alpha)), key);
+				}
+				else
+				{
+					read_dwt(input, secret, channel, levels, Vec3f(float(horizontal), float(vertical), float(alpha)), key);
+				}
 				system("pause");
 				break;
 
@@ -1092,7 +2239,7 @@ main:
 	{
 		string input  = "test/test.mp4";
 		string secret = "test/test.txt";
-		auto store = STORE_FULL, channel = 0, persistence = 50;
+		auto store = STORE_FULL, channel = 0, persistence = 50, order = DCT_ORDER_ROWS, pairs = 1;
 
 	mnvid:
 		switch (show_menu("DCT Configuration", {
@@ -1100,6 +2247,8 @@ main:
 			{ 'd', "Data File:     " + secret },
 			{ 's', "Storage Mode:  " + store_to_string(store) },
 			{ 'c', "Channel Usage: " + channel_to_string(channel) },
+			{ 'o', "Block Order:   " + order_to_string(order) },
+			{ 'n', "Bits/Block:    " + to_string(pairs) },
 			{ 'p', "Persistence:   " + to_string(persistence) + "%" },
 			{ 'a', "Perform Steganography" },
 			{ 'x', "Perform Extraction" },
@@ -1122,17 +2271,25 @@ main:
 			select_channel(channel);
 			goto mnvid;
 
+		case 'o':
+			select_order(order);
+			goto mnvid;
+
+		case 'n':
+			prompt_int("Bits per Block", pairs, 1, DCT_MAX_PAIRS);
+			goto mnvid;
+
 		case 'p':
 			prompt_int("Persistence Percentage", persistence, 0, 100);
 			goto mnvid;
 
 		case 'a':
-			do_dct_vid(input, secret, store, channel, persistence);
+			do_dct_vid(input, secret, store, channel, persistence, order, pairs);
 			system("pause");
 			break;
 
 		case 'x':
-			read_dct_vid(input, channel);
+			read_dct_vid(input, channel, order, pairs);
 			system("pause");
 			break;
 
@@ -1151,8 +2308,19 @@ main:
 			{ '4', "Discrete Cosine Transformation -- All Channels w/ JPEG Compression" },
 			{ '5', "Discrete Wavelet Transformation -- Single Channel" },
 			{ '6', "Discrete Wavelet Transformation -- All Channels w/ JPEG Compression" },
+			{ '7', "Discrete Cosine Transformation -- Kernel Benchmark" },
+			{ '8', "Quantized JPEG Coefficients -- All Components" },
+			{ '9', "Discrete Wavelet Transformation -- Kernel Benchmark" },
+			{ 'a', "Discrete Wavelet Transformation -- Blind Extraction w/ JPEG Compression" },
+			{ 'c', "Discrete Wavelet Transformation -- All Filters and Two Levels w/ JPEG Compression" },
+			{ 'd', "Discrete Cosine Transformation -- PNG Processed in Strips" },
+			{ 'e', "Least Significant Bit -- Kernel Benchmark" },
+			{ 'f', "Least Significant Bit -- 16-bit Image w/ 4 Bits per Sample" },
+			{ 'g', "Least Significant Bit -- Memory-Mapped BMP Image" },
+			{ 'h', "Least Significant Bit -- Matrix Embedding" },
+			{ 'i', "Least Significant Bit -- Keyed Embedding Order" },
 			{ 'b', "Back to Main Menu" }
-		}, "123456"))
+		}, "123456789acdefghi"))
 		{
 		case '1':
 			test_lsb();
@@ -1178,6 +2346,50 @@ main:
 			test_dwt_multi();
 			cvWaitKey();
 			break;
+		case '7':
+			bench_dct();
+			system("pause");
+			break;
+		case '8':
+			test_dct_jpeg();
+			cvWaitKey();
+			break;
+		case '9':
+			bench_dwt();
+			system("pause");
+			break;
+		case 'a':
+			test_dwt_blind();
+			cvWaitKey();
+			break;
+		case 'c':
+			test_dwt_subbands();
+			cvWaitKey();
+			break;
+		case 'd':
+			test_dct_stream();
+			cvWaitKey();
+			break;
+		case 'e':
+			bench_lsb();
+			system("pause");
+			break;
+		case 'f':
+			test_lsb_bits();
+			cvWaitKey();
+			break;
+		case 'g':
+			test_lsb_mapped();
+			cvWaitKey();
+			break;
+		case 'h':
+			test_lsb_matrix();
+			cvWaitKey();
+			break;
+		case 'i':
+			test_lsb_keyed();
+			cvWaitKey();
+			break;
 		case 'b':
 			goto main;
 		}
@@ -0,0 +1,190 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+ * Returns the storage of the number of threads used by parallel loops.
+ * A value of 0 or less means the number of hardware threads.
+ */
+inline int& thread_count_storage()
+{
+	static auto threads = 0;
+	return threads;
+}
+
+/*!
+ * Sets the number of threads used by parallel loops.
+ *
+ * \param threads Number of threads, or 0 to use all hardware threads.
+ */
+inline void set_thread_count(int threads)
+{
+	thread_count_storage() = threads;
+}
+
+/*!
+ * Returns the storage of the flag which makes the parallel loops started by the
+ * current thread run serially, set on threads which already run in parallel with
+ * each other, such as the workers of a pipeline.
+ */
+inline bool& serial_thread_storage()
+{
+	static thread_local auto serial = false;
+	return serial;
+}
+
+/*!
+ * Sets whether the parallel loops started by the current thread run serially.
+ *
+ * \param serial Value indicating whether to run serially.
+ */
+inline void set_thread_serial(bool serial)
+{
+	serial_thread_storage() = serial;
+}
+
+/*!
+ * Returns the number of threads used by parallel loops.
+ *
+ * \return Number of threads, at least 1, or exactly 1 on threads marked with `set_thread_serial`.
+ */
+inline int get_thread_count()
+{
+	if (serial_thread_storage())
+	{
+		return 1;
+	}
+
+	auto threads = thread_count_storage();
+
+	if (threads <= 0)
+	{
+		threads = int(std::thread::hardware_concurrency());
+	}
+
+	return std::max(threads, 1);
+}
+
+/*!
+ * Processes independent stripes on a work-stealing pool.
+ *
+ * Each worker starts with a contiguous range of stripes and takes its work
+ * from the front of that range. Once its own range is exhausted, it steals
+ * the stripe at the back of the fullest range of the other workers. The
+ * calling thread participates as the first worker.
+ *
+ * \param count Number of stripes.
+ * \param body Function to call with the index of each stripe.
+ * \param threads Number of workers, or 0 to use `get_thread_count`.
+ */
+inline void parallel_stripes(int count, const std::function<void(int)>& body, int threads = 0)
+{
+	using namespace std;
+
+	if (count <= 0)
+	{
+		return;
+	}
+
+	if (threads <= 0)
+	{
+		threads = get_thread_count();
+	}
+
+	threads = min(threads, count);
+
+	if (threads == 1)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			body(i);
+		}
+
+		return;
+	}
+
+	struct range
+	{
+		mutex lock;
+		int begin;
+		int end;
+	};
+
+	vector<range> ranges(threads);
+
+	for (int t = 0; t < threads; t++)
+	{
+		ranges[t].begin = int(int64_t(count) * t / threads);
+		ranges[t].end   = int(int64_t(count) * (t + 1) / threads);
+	}
+
+	auto worker = [&](int t)
+	{
+		while (true)
+		{
+			auto next = -1;
+
+			{
+				lock_guard<mutex> guard(ranges[t].lock);
+
+				if (ranges[t].begin < ranges[t].end)
+				{
+					next = ranges[t].begin++;
+				}
+			}
+
+			if (next < 0)
+			{
+				auto victim = -1;
+				auto most   = 0;
+
+				for (int v = 0; v < threads; v++)
+				{
+					lock_guard<mutex> guard(ranges[v].lock);
+
+					if (ranges[v].end - ranges[v].begin > most)
+					{
+						most   = ranges[v].end - ranges[v].begin;
+						victim = v;
+					}
+				}
+
+				if (victim < 0)
+				{
+					return;
+				}
+
+				lock_guard<mutex> guard(ranges[victim].lock);
+
+				if (ranges[victim].begin < ranges[victim].end)
+				{
+					next = --ranges[victim].end;
+				}
+				else
+				{
+					continue;
+				}
+			}
+
+			body(next);
+		}
+	};
+
+	vector<thread> pool;
+
+	for (int t = 1; t < threads; t++)
+	{
+		pool.emplace_back(worker, t);
+	}
+
+	worker(0);
+
+	for (auto& th : pool)
+	{
+		th.join();
+	}
+}
@@ -0,0 +1,306 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+/*!
+ * Number of bytes buffered before extracted data is written to a stream.
+ */
+#define PAYLOAD_CHUNK_SIZE (int64_t(1) << 20)
+
+/*!
+ * Data to hide, made up of segments which are hidden one after the other without
+ * being concatenated first. Segments either borrow memory owned by the caller,
+ * point into a memory-mapped file, or hold short strings, such as headers, owned
+ * by the payload itself. This way the contents of a file are hidden directly from
+ * the page cache, without reading them into a string and copying them around.
+ */
+class Payload
+{
+public:
+
+	/*!
+	 * Initializes an empty payload.
+	 */
+	Payload()
+		: total(0)
+	{
+	}
+
+	Payload(Payload&& other) = default;
+	Payload& operator=(Payload&& other) = default;
+
+	Payload(const Payload&) = delete;
+	Payload& operator=(const Payload&) = delete;
+
+	/*!
+	 * Appends a segment borrowed from the caller, which has to outlive the payload.
+	 *
+	 * \param data Bytes of the segment.
+	 * \param size Number of bytes.
+	 *
+	 * \return The payload itself.
+	 */
+	Payload& append(const void* data, int64_t size)
+	{
+		if (size > 0)
+		{
+			segments.push_back(std::make_pair(static_cast<const unsigned char*>(data), size));
+			total += size;
+		}
+
+		return *this;
+	}
+
+	/*!
+	 * Appends a segment owned by the payload.
+	 *
+	 * \param text Bytes of the segment.
+	 *
+	 * \return The payload itself.
+	 */
+	Payload& append(std::string text)
+	{
+		owned.push_back(std::move(text));
+		return append(owned.back().data(), int64_t(owned.back().length()));
+	}
+
+	/*!
+	 * Appends the segments of another payload, which has to outlive this one.
+	 *
+	 * \param other Payload to borrow the segments of.
+	 *
+	 * \return The payload itself.
+	 */
+	Payload& append(const Payload& other)
+	{
+		for (auto& segment : other.segments)
+		{
+			append(segment.first, segment.second);
+		}
+
+		return *this;
+	}
+
+	/*!
+	 * Maps a file into memory and appends its contents.
+	 *
+	 * \param file Path to the file.
+	 *
+	 * \return Value indicating whether the file could be read.
+	 */
+	bool map(const std::string& file)
+	{
+		using namespace boost::interprocess;
+
+		// empty files cannot be mapped, but are valid payloads
+		std::ifstream fs(file, std::ios::binary | std::ios::ate);
+
+		if (!fs)
+		{
+			return false;
+		}
+
+		if (fs.tellg() <= 0)
+		{
+			return true;
+		}
+
+		try
+		{
+			file_mapping mapping(file.c_str(), read_only);
+			regions.push_back(mapped_region(mapping, read_only));
+		}
+		catch (const interprocess_exception&)
+		{
+			return false;
+		}
+
+		append(regions.back().get_address(), int64_t(regions.back().get_size()));
+		return true;
+	}
+
+	/*!
+	 * Returns the number of bytes in the payload.
+	 *
+	 * \return Total size of the segments.
+	 */
+	int64_t size() const
+	{
+		return total;
+	}
+
+	/*!
+	 * Copies a range of the payload into a buffer.
+	 *
+	 * \param offset Index of the first byte to copy.
+	 * \param length Number of bytes to copy, bytes past the end of the payload are filled with zeros.
+	 * \param dst Buffer to copy to.
+	 */
+	void read(int64_t offset, int64_t length, void* dst) const
+	{
+		auto out = static_cast<unsigned char*>(dst);
+
+		split(offset, length, [&](const unsigned char* data, int64_t index, int64_t position, int64_t count)
+		{
+			if (data)
+			{
+				memcpy(out + position, data + index, size_t(count));
+			}
+			else
+			{
+				memset(out + position, 0, size_t(count));
+			}
+		});
+	}
+
+	/*!
+	 * Copies the whole payload into a string.
+	 *
+	 * \return Contents of the payload.
+	 */
+	std::string str() const
+	{
+		std::string text(size_t(total), 0);
+
+		if (total > 0)
+		{
+			read(0, total, &text[0]);
+		}
+
+		return text;
+	}
+
+	/*!
+	 * Splits a range of units spanning multiple segments into runs within a single segment.
+	 * The units are bytes, or bits when `scale` is 8, in which case each segment covers
+	 * eight times its size in bytes.
+	 *
+	 * \param first Index of the first unit.
+	 * \param count Number of units.
+	 * \param function Function receiving the bytes of the segment, or null past the end of the payload,
+	 *                 the index of the first unit within the segment, the offset of the run within the
+	 *                 range, and the number of units in the run.
+	 * \param scale Number of units per byte.
+	 */
+	template<typename Function>
+	void split(int64_t first, int64_t count, Function function, int scale = 1) const
+	{
+		auto base = int64_t(0);
+		auto done = int64_t(0);
+
+		for (auto& segment : segments)
+		{
+			auto end = base + segment.second * scale;
+
+			if (first + done < end)
+			{
+				auto n = std::min(count - done, end - first - done);
+
+				function(segment.first, first + done - base, done, n);
+				done += n;
+
+				if (done == count)
+				{
+					return;
+				}
+			}
+
+			base = end;
+		}
+
+		if (done < count)
+		{
+			function(nullptr, first + done - base, done, count - done);
+		}
+	}
+
+private:
+
+	std::vector<std::pair<const unsigned char*, int64_t>> segments;
+	std::list<std::string> owned;
+	std::list<boost::interprocess::mapped_region> regions;
+	int64_t total;
+};
+
+/*!
+ * Stream buffer comparing the bytes written to it with a payload instead of storing them,
+ * so extracted data can be verified against the original in bounded memory.
+ */
+class PayloadMatcher : public std::streambuf
+{
+public:
+
+	/*!
+	 * Initializes a new instance of the matcher.
+	 *
+	 * \param payload Payload to compare with, which has to outlive the matcher.
+	 */
+	explicit PayloadMatcher(const Payload& payload)
+		: payload(payload), compared(0), matches(0)
+	{
+	}
+
+	/*!
+	 * Returns the number of bytes written.
+	 *
+	 * \return Number of bytes compared so far, including the ones past the end of the payload.
+	 */
+	int64_t written() const
+	{
+		return compared;
+	}
+
+	/*!
+	 * Returns the number of bytes which matched the payload.
+	 *
+	 * \return Number of bytes equal to the byte of the payload at the same position.
+	 */
+	int64_t matched() const
+	{
+		return matches;
+	}
+
+protected:
+
+	std::streamsize xsputn(const char* data, std::streamsize count) override
+	{
+		auto n = std::max(int64_t(0), std::min(int64_t(count), payload.size() - compared));
+
+		payload.split(compared, n, [&](const unsigned char* bytes, int64_t index, int64_t offset, int64_t length)
+		{
+			for (int64_t i = 0; i < length; i++)
+			{
+				matches += bytes[index + i] == static_cast<unsigned char>(data[offset + i]);
+			}
+		});
+
+		compared += count;
+		return count;
+	}
+
+	int_type overflow(int_type ch) override
+	{
+		if (!traits_type::eq_int_type(ch, traits_type::eof()))
+		{
+			auto c = traits_type::to_char_type(ch);
+			xsputn(&c, 1);
+		}
+
+		return traits_type::not_eof(ch);
+	}
+
+private:
+
+	const Payload& payload;
+	int64_t compared;
+	int64_t matches;
+};
@@ -0,0 +1,196 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/*!
+ * Number of Feistel rounds applied per encryption.
+ */
+#define PERMUTATION_ROUNDS 6
+
+/*!
+ * Keyed pseudo-random permutation of the indices `[0, size)`, used to scatter
+ * the hidden bits over the whole image instead of writing them in raster order.
+ *
+ * The indices are encrypted with a balanced Feistel network over the smallest
+ * even number of bits covering the range, and encryptions falling outside the
+ * range are encrypted again until they land within it (cycle walking). As the
+ * domain is less than four times the range, few walks are needed on average.
+ * Positions are computed on the fly, so no index table is kept in memory.
+ *
+ * An empty key yields the identity permutation, which keeps the raster order.
+ */
+class Permutation
+{
+public:
+
+	/*!
+	 * Initializes the identity permutation.
+	 */
+	Permutation()
+		: count(0), half(0), mask(0), keyed(false)
+	{
+	}
+
+	/*!
+	 * Initializes a new instance of the permutation.
+	 *
+	 * \param size Number of indices to permute.
+	 * \param key Secret key, or an empty string for the identity permutation.
+	 */
+	Permutation(uint64_t size, const std::string& key)
+		: count(size), half(0), mask(0), keyed(!key.empty() && size > 1)
+	{
+		if (!keyed)
+		{
+			return;
+		}
+
+		auto bits = 0;
+
+		while (bits < 64 && (size - 1) >> bits != 0)
+		{
+			bits++;
+		}
+
+		half = (bits + 1) / 2;
+		mask = (uint64_t(1) << half) - 1;
+
+		// FNV-1a of the key, spread over the round keys
+		auto seed = 14695981039346656037ull;
+
+		for (auto c : key)
+		{
+			seed ^= uint8_t(c);
+			seed *= 1099511628211ull;
+		}
+
+		for (int r = 0; r < PERMUTATION_ROUNDS; r++)
+		{
+			rounds[r] = mix(seed + (r + 1) * 0x9E3779B97F4A7C15ull);
+		}
+	}
+
+	/*!
+	 * Determines whether the permutation keeps the indices in order.
+	 *
+	 * \return Value indicating whether no key was specified.
+	 */
+	bool identity() const
+	{
+		return !keyed;
+	}
+
+	/*!
+	 * Returns the position of an index.
+	 *
+	 * \param index Index within `[0, size)`.
+	 *
+	 * \return Permuted position within `[0, size)`.
+	 */
+	uint64_t operator()(uint64_t index) const
+	{
+		if (!keyed)
+		{
+			return index;
+		}
+
+		do
+		{
+			index = encrypt(index);
+		}
+		while (index >= count);
+
+		return index;
+	}
+
+	/*!
+	 * Returns the index placed at a position, the inverse of `operator()`.
+	 *
+	 * \param position Position within `[0, size)`.
+	 *
+	 * \return Index within `[0, size)`.
+	 */
+	uint64_t inverse(uint64_t position) const
+	{
+		if (!keyed)
+		{
+			return position;
+		}
+
+		do
+		{
+			position = decrypt(position);
+		}
+		while (position >= count);
+
+		return position;
+	}
+
+private:
+
+	/*!
+	 * Scrambles the bits of a value, the finalizer of SplitMix64.
+	 */
+	static uint64_t mix(uint64_t x)
+	{
+		x ^= x >> 30;
+		x *= 0xBF58476D1CE4E5B9ull;
+		x ^= x >> 27;
+		x *= 0x94D049BB133111EBull;
+		x ^= x >> 31;
+
+		return x;
+	}
+
+	/*!
+	 * Round function, a multiplicative hash of a half and the round key, keeping the high bits.
+	 */
+	uint64_t scramble(uint64_t x, int r) const
+	{
+		return ((x ^ rounds[r]) * 0x9E3779B97F4A7C15ull) >> (64 - half);
+	}
+
+	/*!
+	 * Applies the Feistel rounds to a value of `2 * half` bits.
+	 */
+	uint64_t encrypt(uint64_t x) const
+	{
+		auto left  = x >> half;
+		auto right = x & mask;
+
+		for (int r = 0; r < PERMUTATION_ROUNDS; r++)
+		{
+			auto next = left ^ scramble(right, r);
+
+			left  = right;
+			right = next;
+		}
+
+		return left << half | right;
+	}
+
+	/*!
+	 * Reverts the Feistel rounds applied by `encrypt`.
+	 */
+	uint64_t decrypt(uint64_t x) const
+	{
+		auto left  = x >> half;
+		auto right = x & mask;
+
+		for (int r = PERMUTATION_ROUNDS - 1; r >= 0; r--)
+		{
+			auto prev = right ^ scramble(left, r);
+
+			right = left;
+			left  = prev;
+		}
+
+		return left << half | right;
+	}
+
+	uint64_t count;
+	int half;
+	uint64_t mask;
+	bool keyed;
+	uint64_t rounds[PERMUTATION_ROUNDS];
+};
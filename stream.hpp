@@ -0,0 +1,725 @@
+#pragma once
+#include <csetjmp>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <png.h>
+#include <opencv2/core/core.hpp>
+#include "helpers.hpp"
+#include "dct.hpp"
+#include "dwt.hpp"
+#include "lsb_kernel.hpp"
+#include "tlv.hpp"
+
+/*!
+ * Default number of rows read into memory at once by the streaming functions.
+ */
+#define STREAM_STRIP_HEIGHT 256
+
+/*!
+ * Number of channels of the strips read by the streaming functions, as with `cv::imread`.
+ */
+#define STREAM_CHANNELS 3
+
+/*!
+ * Error handler shared by the read and write structures, which returns control to the caller
+ * instead of terminating the process.
+ */
+struct stream_png_error
+{
+	jmp_buf jump;
+};
+
+/*!
+ * Handles fatal libpng errors by jumping back to the caller.
+ *
+ * \param png Read or write structure which failed.
+ */
+inline void stream_png_error_exit(png_structp png, png_const_charp)
+{
+	longjmp(static_cast<stream_png_error*>(png_get_error_ptr(png))->jump, 1);
+}
+
+/*!
+ * Handles libpng warnings by ignoring them.
+ */
+inline void stream_png_warning(png_structp, png_const_charp)
+{
+}
+
+/*!
+ * Reads a PNG image in horizontal strips, and optionally writes the strips
+ * into another PNG image after they were processed. Only a single strip is
+ * kept in memory, so the memory use is bounded by the strip height instead
+ * of the size of the image.
+ *
+ * The samples are read as with `cv::imread`: gray images are expanded to
+ * three channels, the alpha channel is dropped, 16-bit samples are cut to
+ * 8 bits, and the channels are in BGR order. The processed image is written
+ * the same way `cv::imwrite` writes such strips, as an 8-bit RGB image.
+ * Interlaced images can not be read row by row, and are therefore not supported.
+ *
+ * \param input Path to the image to read.
+ * \param output Path to write the processed image to, or empty to only read.
+ * \param strip_height Number of rows per strip, the last strip may be shorter.
+ * \param process Function receiving each strip, its first row and the height of the image.
+ *                It may alter the strip in-place, and returns false once no more strips need
+ *                to be processed, after which the remaining rows are copied as they are,
+ *                or not read at all when only reading.
+ *
+ * \return Value indicating whether the operation was successful.
+ */
+inline bool stream_png(const std::string& input, const std::string& output, int strip_height, const std::function<bool(cv::Mat& strip, int top, int height)>& process)
+{
+	using namespace cv;
+	using namespace std;
+
+	auto src_file = fopen(input.c_str(), "rb");
+
+	if (!src_file)
+	{
+		return false;
+	}
+
+	FILE* dst_file = nullptr;
+
+	if (!output.empty() && !(dst_file = fopen(output.c_str(), "wb")))
+	{
+		fclose(src_file);
+		return false;
+	}
+
+	stream_png_error err;
+
+	auto src = png_create_read_struct(PNG_LIBPNG_VER_STRING, &err, stream_png_error_exit, stream_png_warning);
+	auto src_info = src ? png_create_info_struct(src) : nullptr;
+
+	auto dst = dst_file ? png_create_write_struct(PNG_LIBPNG_VER_STRING, &err, stream_png_error_exit, stream_png_warning) : nullptr;
+	auto dst_info = dst ? png_create_info_struct(dst) : nullptr;
+
+	// objects with destructors are declared before the jump target is set,
+	// so returning to it does not skip over any destructors
+
+	Mat strip;
+	auto failed = !src_info || (dst_file && !dst_info);
+
+	if (failed)
+	{
+	}
+	else if (setjmp(err.jump))
+	{
+		failed = true;
+	}
+	else
+	{
+		png_init_io(src, src_file);
+		png_read_info(src, src_info);
+
+		if (png_get_interlace_type(src, src_info) != PNG_INTERLACE_NONE)
+		{
+			png_error(src, "interlaced images are not supported");
+		}
+
+		png_set_expand(src);
+		png_set_strip_16(src);
+		png_set_strip_alpha(src);
+		png_set_gray_to_rgb(src);
+		png_set_bgr(src);
+		png_read_update_info(src, src_info);
+
+		auto width  = int(png_get_image_width(src, src_info));
+		auto height = int(png_get_image_height(src, src_info));
+
+		if (dst)
+		{
+			png_init_io(dst, dst_file);
+			png_set_IHDR(dst, dst_info, png_uint_32(width), png_uint_32(height), 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+			png_write_info(dst, dst_info);
+			png_set_bgr(dst);
+		}
+
+		strip.create(max(1, min(strip_height, height)), width, CV_8UC(STREAM_CHANNELS));
+
+		auto processing = true;
+
+		for (int top = 0; top < height; top += strip.rows)
+		{
+			auto rows = min(strip.rows, height - top);
+
+			if (!processing && !dst)
+			{
+				break;
+			}
+
+			for (int y = 0; y < rows; y++)
+			{
+				png_read_row(src, strip.ptr(y), nullptr);
+			}
+
+			if (processing)
+			{
+				Mat part = strip.rowRange(0, rows);
+				processing = process(part, top, height);
+			}
+
+			if (dst)
+			{
+				for (int y = 0; y < rows; y++)
+				{
+					png_write_row(dst, strip.ptr(y));
+				}
+			}
+		}
+
+		if (dst)
+		{
+			png_write_end(dst, nullptr);
+		}
+	}
+
+	if (dst)
+	{
+		png_destroy_write_struct(&dst, &dst_info);
+	}
+
+	png_destroy_read_struct(&src, src_info ? &src_info : nullptr, nullptr);
+
+	fclose(src_file);
+
+	if (dst_file)
+	{
+		fclose(dst_file);
+
+		if (failed)
+		{
+			remove(output.c_str());
+		}
+	}
+
+	return !failed;
+}
+
+/*!
+ * Rounds the height of a strip up to a multiple of the block size of a method.
+ *
+ * \param strip_height Requested number of rows per strip.
+ * \param block Number of rows processed together by the method.
+ *
+ * \return Number of rows per strip.
+ */
+inline int stream_strip_height(int strip_height, int block)
+{
+	return (std::max(strip_height, 1) + block - 1) / block * block;
+}
+
+/*!
+ * Hides data in a PNG image by manipulating the least significant bits of each sample,
+ * reading and writing the image in strips. The result is identical to `encode_lsb` on the image read with `cv::imread`.
+ *
+ * \param input Path to the original PNG image.
+ * \param output Path to write the altered PNG image to.
+ * \param payload Payload to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param strip_height Number of rows kept in memory.
+ *
+ * \return Value indicating whether the operation was successful.
+ */
+inline bool encode_lsb_stream(const std::string& input, const std::string& output, const Payload& payload, int mode = STORE_ONCE, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	// the terminating null character is hidden as well, as done by `encode_lsb`
+	auto size = (payload.size() + 1) * 8;
+
+	return stream_png(input, output, strip_height, [&](cv::Mat& strip, int top, int)
+	{
+		auto stride = int64_t(strip.cols) * strip.channels();
+
+		for (int y = 0; y < strip.rows; y++)
+		{
+			auto row = strip.ptr<uchar>(y);
+
+			auto more = lsb_embed_run((top + y) * stride, stride, size, mode,
+				[&](int64_t offset, int64_t first, int64_t count) { lsb_embed_payload(row + offset, row + offset, payload, first, count); },
+				[&](int64_t offset, int64_t count) { lsb_clear_bits(row + offset, row + offset, count); });
+
+			if (!more)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	});
+}
+
+/*!
+ * Hides text in a PNG image by manipulating the least significant bits of each sample,
+ * reading and writing the image in strips. The result is identical to `encode_lsb` on the image read with `cv::imread`.
+ *
+ * \param input Path to the original PNG image.
+ * \param output Path to write the altered PNG image to.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param strip_height Number of rows kept in memory.
+ *
+ * \return Value indicating whether the operation was successful.
+ */
+inline bool encode_lsb_stream(const std::string& input, const std::string& output, const std::string& text, int mode = STORE_ONCE, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	return encode_lsb_stream(input, output, Payload().append(text.data(), int64_t(text.length())), mode, strip_height);
+}
+
+/*!
+ * Recovers a range of the data hidden in a PNG image using least significant bit manipulation,
+ * reading the image in strips, and only up to the last row carrying the requested bytes.
+ * The data is written to a stream in chunks, so neither the image nor the data has to fit in memory.
+ *
+ * \param input Path to the PNG image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ * \param out Stream to write the extracted data to.
+ * \param strip_height Number of rows kept in memory.
+ *
+ * \return Number of bytes written, fewer than requested if the image is too small.
+ */
+inline int64_t decode_lsb_stream_range_to(const std::string& input, int64_t offset, int64_t length, std::ostream& out, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	using namespace std;
+
+	unique_ptr<LsbWriter> writer;
+
+	auto first = offset * 8;
+	auto last  = first;
+
+	stream_png(input, "", strip_height, [&](cv::Mat& strip, int top, int height)
+	{
+		auto stride = int64_t(strip.cols) * strip.channels();
+
+		if (top == 0)
+		{
+			last   = first + max(int64_t(0), min(length, stride * height / 8 - offset)) * 8;
+			writer.reset(new LsbWriter(out, first, last));
+		}
+
+		auto base = top * stride;
+
+		for (auto b = max(first, base); b < min(last, base + strip.rows * stride);)
+		{
+			auto y = int((b - base) / stride);
+			auto x = (b - base) % stride;
+			auto n = min(last - b, stride - x);
+
+			if (!writer->extract(strip.ptr<uchar>(y) + x, b, n))
+			{
+				return false;
+			}
+
+			b += n;
+		}
+
+		return base + strip.rows * stride < last;
+	});
+
+	return writer ? writer->written() : 0;
+}
+
+/*!
+ * Recovers a range of the data hidden in a PNG image using least significant bit manipulation,
+ * reading the image in strips, and only up to the last row carrying the requested bytes.
+ *
+ * \param input Path to the PNG image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ * \param strip_height Number of rows kept in memory.
+ *
+ * \return Hidden data extracted form image, shorter than requested if the image is too small.
+ */
+inline std::string decode_lsb_stream_range(const std::string& input, int64_t offset, int64_t length, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	std::ostringstream out;
+	decode_lsb_stream_range_to(input, offset, length, out, strip_height);
+	return out.str();
+}
+
+/*!
+ * Recovers data hidden in a PNG image using least significant bit manipulation, reading the image in strips.
+ *
+ * \param input Path to the PNG image with hidden data.
+ * \param strip_height Number of rows kept in memory.
+ *
+ * \return Hidden data extracted form image.
+ */
+inline std::string decode_lsb_stream(const std::string& input, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	return decode_lsb_stream_range(input, 0, INT64_MAX, strip_height);
+}
+
+/*!
+ * Recovers data encapsulated with `encode_tlv` and hidden in a PNG image using least significant bit
+ * manipulation, reading the image in strips. The header is extracted first, and only the rows up to
+ * the end of the payload are read afterwards.
+ *
+ * \param input Path to the PNG image with hidden data.
+ * \param strip_height Number of rows kept in memory.
+ *
+ * \return Hidden data extracted form image, or an empty string if the header is invalid.
+ */
+inline std::string decode_lsb_stream_tlv(const std::string& input, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	return decode_tlv_lazy([&](int64_t offset, int64_t length) { return decode_lsb_stream_range(input, offset, length, strip_height); });
+}
+
+/*!
+ * Recovers data encapsulated with `encode_tlv` and hidden in a PNG image using least significant bit
+ * manipulation, reading the image in strips, and writing the data to a stream in chunks.
+ *
+ * \param input Path to the PNG image with hidden data.
+ * \param out Stream to write the extracted data to.
+ * \param strip_height Number of rows kept in memory.
+ *
+ * \return Number of bytes written, or -1 if the header is invalid.
+ */
+inline int64_t decode_lsb_stream_tlv_to(const std::string& input, std::ostream& out, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	return decode_tlv_stream([&](int64_t offset, int64_t length, std::ostream& stream) { return decode_lsb_stream_range_to(input, offset, length, stream, strip_height); }, out);
+}
+
+/*!
+ * Uses discrete cosine transformation to hide data in the coefficients of multiple channels of a PNG image,
+ * reading and writing the image in strips of whole blocks. The blocks are visited row by row, and the
+ * result is identical to `encode_dct` with DCT_ORDER_ROWS.
+ *
+ * \param input Path to the original PNG image.
+ * \param output Path to write the altered PNG image to.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param channels Channels to manipulate.
+ * \param intensity Persistence of the hidden data.
+ * \param pairs Number of bits to hide per block, at most DCT_MAX_PAIRS.
+ * \param strip_height Number of rows kept in memory, rounded up to whole blocks.
+ *
+ * \return Value indicating whether the operation was successful, false if a channel or the number of pairs is out of range.
+ */
+inline bool encode_dct_stream(const std::string& input, const std::string& output, const std::string& text, int mode = STORE_FULL, const std::vector<int>& channels = std::vector<int> { 0 }, int intensity = 30, int pairs = 1, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	using namespace std;
+
+	if (!dct_pairs_supported(pairs))
+	{
+		return false;
+	}
+
+	for (auto channel : channels)
+	{
+		if (channel < 0 || channel >= STREAM_CHANNELS)
+		{
+			return false;
+		}
+	}
+
+	auto size = int64_t(text.length()) * 8;
+
+	return stream_png(input, output, stream_strip_height(strip_height, Dct<8>::size), [&](cv::Mat& strip, int top, int height)
+	{
+		// the last row and column of blocks are not used, as with `encode_dct`
+
+		auto grid_width  = strip.cols / Dct<8>::size - 1;
+		auto grid_height = height / Dct<8>::size - 1;
+		auto grid_top    = top / Dct<8>::size;
+		auto grid_rows   = min(strip.rows / Dct<8>::size, grid_height - grid_top);
+
+		for (int y = 0; y < grid_rows; y++)
+		{
+			float block[Dct<8>::size * Dct<8>::size];
+			int vals[DCT_MAX_PAIRS];
+
+			for (int x = 0; x < grid_width; x++)
+			{
+				auto k = dct_block_index(x, grid_top + y, grid_width, grid_height, DCT_ORDER_ROWS);
+				auto touched = false;
+
+				for (int j = 0; j < pairs; j++)
+				{
+					auto i = dct_block_bit(k * pairs + j, size, mode);
+
+					vals[j] = -1;
+
+					if (i < 0)
+					{
+						continue;
+					}
+
+					vals[j] = 0;
+					if (i < size)
+					{
+						vals[j] = (text[i / 8] & 1 << i % 8) >> i % 8;
+					}
+
+					touched = true;
+				}
+
+				if (!touched)
+				{
+					return false;
+				}
+
+				for (auto channel : channels)
+				{
+					dct_load_block<uchar>(strip, x * Dct<8>::size, y * Dct<8>::size, channel, block);
+					dct_embed_block(block, vals, pairs, intensity);
+					dct_store_block<uchar>(strip, x * Dct<8>::size, y * Dct<8>::size, channel, block);
+				}
+			}
+		}
+
+		return grid_top + grid_rows < grid_height;
+	});
+}
+
+/*!
+ * Uses discrete cosine transformation to recover a range of the data hidden in the coefficients of a PNG image
+ * with `encode_dct_stream`, reading the image in strips, and only up to the last row of blocks carrying the
+ * requested bytes.
+ *
+ * \param input Path to the PNG image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ * \param channel Channel to manipulate.
+ * \param pairs Number of bits hidden per block, at most DCT_MAX_PAIRS.
+ * \param strip_height Number of rows kept in memory, rounded up to whole blocks.
+ *
+ * \return Hidden data extracted form image, shorter than requested if the image is too small,
+ *         or an empty string if the channel or the number of pairs is out of range.
+ */
+inline std::string decode_dct_stream_range(const std::string& input, int64_t offset, int64_t length, int channel = 0, int pairs = 1, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	using namespace std;
+
+	if (channel < 0 || channel >= STREAM_CHANNELS || !dct_pairs_supported(pairs))
+	{
+		return string();
+	}
+
+	string bits;
+
+	stream_png(input, "", stream_strip_height(strip_height, Dct<8>::size), [&](cv::Mat& strip, int top, int height)
+	{
+		auto grid_width  = strip.cols / Dct<8>::size - 1;
+		auto grid_height = height / Dct<8>::size - 1;
+		auto grid_top    = top / Dct<8>::size;
+		auto grid_rows   = max(0, min(strip.rows / Dct<8>::size, grid_height - grid_top));
+
+		if (top == 0)
+		{
+			// the capacity is reported for the whole grid, as with `decode_dct_range`
+
+			auto capacity = int64_t(grid_width + 1) * (grid_height + 1) * pairs / 8;
+
+			bits.assign(size_t(max(int64_t(0), min(length, capacity - offset))), 0);
+		}
+
+		auto first = offset * 8;
+		auto last  = first + int64_t(bits.size()) * 8;
+		auto begin = int64_t(grid_top) * grid_width * pairs;
+		auto end   = int64_t(grid_top + grid_rows) * grid_width * pairs;
+
+		if (grid_width < 1)
+		{
+			return false;
+		}
+
+		float block[Dct<8>::size * Dct<8>::size];
+		int vals[DCT_MAX_PAIRS];
+
+		for (auto k = max(first, begin) / pairs; k < (min(last, end) + pairs - 1) / pairs; k++)
+		{
+			auto x = int(k % grid_width);
+			auto y = int(k / grid_width) - grid_top;
+
+			dct_load_block<uchar>(strip, x * Dct<8>::size, y * Dct<8>::size, channel, block);
+			dct_extract_block(block, vals, pairs);
+
+			for (int j = 0; j < pairs; j++)
+			{
+				auto i = k * pairs + j;
+
+				if (i >= first && i < last && vals[j])
+				{
+					bits[(i - first) / 8] |= 1 << i % 8;
+				}
+			}
+		}
+
+		return end < last;
+	});
+
+	return bits;
+}
+
+/*!
+ * Uses discrete cosine transformation to recover data hidden in the coefficients of a PNG image
+ * with `encode_dct_stream`, reading the image in strips.
+ *
+ * \param input Path to the PNG image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param pairs Number of bits hidden per block, at most DCT_MAX_PAIRS.
+ * \param strip_height Number of rows kept in memory, rounded up to whole blocks.
+ *
+ * \return Hidden data extracted form image.
+ */
+inline std::string decode_dct_stream(const std::string& input, int channel = 0, int pairs = 1, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	return decode_dct_stream_range(input, 0, INT64_MAX, channel, pairs, strip_height);
+}
+
+/*!
+ * Uses discrete cosine transformation to recover data encapsulated with `encode_tlv` and hidden in a PNG image
+ * with `encode_dct_stream`. The header is extracted first, and only the rows up to the end of the payload are
+ * read afterwards.
+ *
+ * \param input Path to the PNG image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param pairs Number of bits hidden per block, at most DCT_MAX_PAIRS.
+ * \param strip_height Number of rows kept in memory, rounded up to whole blocks.
+ *
+ * \return Hidden data extracted form image, or an empty string if the header is invalid.
+ */
+inline std::string decode_dct_stream_tlv(const std::string& input, int channel = 0, int pairs = 1, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	return decode_tlv_lazy([&](int64_t offset, int64_t length) { return decode_dct_stream_range(input, offset, length, channel, pairs, strip_height); });
+}
+
+/*!
+ * Uses discrete wavelet transformation to hide data in the diagonal filter of a channel of a PNG image,
+ * reading and writing the image in strips of whole row pairs. The result is identical to `encode_dwt`,
+ * or to `encode_dwt_blind` for extraction without the original image.
+ *
+ * \param input Path to the original PNG image.
+ * \param output Path to write the altered PNG image to.
+ * \param text Text to hide.
+ * \param mode Storage mode, see STORE_* constants.
+ * \param channel Channel to manipulate.
+ * \param alpha Encoding intensity.
+ * \param blind Hide the data for extraction without the original image.
+ * \param strip_height Number of rows kept in memory, rounded up to whole row pairs.
+ *
+ * \return Value indicating whether the operation was successful, false if a channel is out of range.
+ */
+inline bool encode_dwt_stream(const std::string& input, const std::string& output, const std::string& text, int mode = STORE_FULL, int channel = 0, float alpha = 0.1, bool blind = false, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	if (channel < 0 || channel >= STREAM_CHANNELS)
+	{
+		return false;
+	}
+
+	return stream_png(input, output, stream_strip_height(strip_height, 2), [&](cv::Mat& strip, int top, int)
+	{
+		// strips past the data are still transformed, as the values of the whole channel are clamped
+
+		auto first = int64_t(top / 2) * (strip.cols / 2);
+
+		if (blind)
+		{
+			dwt_encode_diagonal(strip, text, mode, channel, alpha, [=](float c, int val) { return dwt_blind_embed(c, val, alpha); }, first).copyTo(strip);
+		}
+		else
+		{
+			dwt_encode_diagonal(strip, text, mode, channel, alpha, [=](float c, int val) { return val == 1 ? c + alpha : c - alpha; }, first).copyTo(strip);
+		}
+
+		return true;
+	});
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover a range of the data hidden in the diagonal filter of a PNG image
+ * with `encode_dwt_stream` for extraction without the original image. The image is read in strips, and only up to
+ * the last row pair carrying the requested bytes.
+ *
+ * \param input Path to the PNG image with hidden data.
+ * \param offset Index of the first byte to extract.
+ * \param length Number of bytes to extract.
+ * \param channel Channel to manipulate.
+ * \param strip_height Number of rows kept in memory, rounded up to whole row pairs.
+ *
+ * \return Hidden data extracted form image, shorter than requested if the image is too small.
+ */
+inline std::string decode_dwt_blind_stream_range(const std::string& input, int64_t offset, int64_t length, int channel = 0, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	using namespace std;
+
+	if (channel < 0 || channel >= STREAM_CHANNELS)
+	{
+		return string();
+	}
+
+	string bits;
+
+	stream_png(input, "", stream_strip_height(strip_height, 2), [&](cv::Mat& strip, int top, int height)
+	{
+		auto width = strip.cols / 2;
+		auto rows  = strip.rows / 2;
+
+		if (top == 0)
+		{
+			bits.assign(size_t(max(int64_t(0), min(length, int64_t(width) * (height / 2) / 8 - offset))), 0);
+		}
+
+		auto first = offset * 8;
+		auto last  = first + int64_t(bits.size()) * 8;
+		auto begin = int64_t(top / 2) * width;
+		auto end   = begin + int64_t(rows) * width;
+
+		if (rows > 0 && width > 0 && max(first, begin) < min(last, end))
+		{
+			auto dds = dwt_diagonal_rows(strip, 0, rows, channel);
+
+			for (auto i = max(first, begin); i < min(last, end); i++)
+			{
+				if (dds.at<float>(int((i - begin) / width), int((i - begin) % width)) > 0)
+				{
+					bits[(i - first) / 8] |= 1 << i % 8;
+				}
+			}
+		}
+
+		return end < last;
+	});
+
+	return bits;
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover data hidden in the diagonal filter of a PNG image
+ * with `encode_dwt_stream` for extraction without the original image, reading the image in strips.
+ *
+ * \param input Path to the PNG image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param strip_height Number of rows kept in memory, rounded up to whole row pairs.
+ *
+ * \return Hidden data extracted form image.
+ */
+inline std::string decode_dwt_blind_stream(const std::string& input, int channel = 0, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	return decode_dwt_blind_stream_range(input, 0, INT64_MAX, channel, strip_height);
+}
+
+/*!
+ * Uses discrete wavelet transformation to recover data encapsulated with `encode_tlv` and hidden in a PNG image
+ * with `encode_dwt_stream` for extraction without the original image. The header is extracted first, and only
+ * the rows up to the end of the payload are read afterwards.
+ *
+ * \param input Path to the PNG image with hidden data.
+ * \param channel Channel to manipulate.
+ * \param strip_height Number of rows kept in memory, rounded up to whole row pairs.
+ *
+ * \return Hidden data extracted form image, or an empty string if the header is invalid.
+ */
+inline std::string decode_dwt_blind_stream_tlv(const std::string& input, int channel = 0, int strip_height = STREAM_STRIP_HEIGHT)
+{
+	return decode_tlv_lazy([&](int64_t offset, int64_t length) { return decode_dwt_blind_stream_range(input, offset, length, channel, strip_height); });
+}
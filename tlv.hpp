@@ -1,5 +1,37 @@
 #pragma once
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <sstream>
 #include <string>
+#include "payload.hpp"
+
+/*!
+ * Size of the header preceding the encapsulated text.
+ */
+#define TLV_HEADER_SIZE int64_t(sizeof(int) * 2)
+
+/*!
+ * Maximum length of the encapsulated text, as the length is stored in an `int`.
+ */
+#define TLV_MAX_LENGTH int64_t(INT_MAX)
+
+/*!
+ * Builds the header preceding the encapsulated text.
+ *
+ * \param length Length of the text, at most TLV_MAX_LENGTH.
+ *
+ * \return Header of the TLV packet.
+ */
+inline std::string tlv_header(int64_t length)
+{
+	auto size = int(length);
+	auto xize = ~size;
+
+	return std::string(reinterpret_cast<char*>(&size), sizeof(int)) + std::string(reinterpret_cast<char*>(&xize), sizeof(int));
+}
 
 /*!
 * Encapsulates the specified input into TLV format.
@@ -9,14 +41,37 @@
 *
 * \param text Input to be encapsulated.
 *
-* \return Encapsulated text.
+* \return Encapsulated text, or an empty string if the input is longer than TLV_MAX_LENGTH.
 */
-std::string encode_tlv(const std::string& text)
+inline std::string encode_tlv(const std::string& text)
 {
-	auto size = int(text.length());
-	auto xize = ~size;
+	if (int64_t(text.length()) > TLV_MAX_LENGTH)
+	{
+		return std::string();
+	}
 
-	return std::string(reinterpret_cast<char*>(&size), sizeof(int)) + std::string(reinterpret_cast<char*>(&xize), sizeof(int)) + text;
+	return tlv_header(int64_t(text.length())) + text;
+}
+
+/*!
+ * Encapsulates a payload into TLV format, by placing the header in a segment before
+ * the segments of the data, so the data itself is not copied.
+ *
+ * \param payload Payload to be encapsulated, which has to outlive the encapsulated payload.
+ *
+ * \return Encapsulated payload, or an empty payload if the input is longer than TLV_MAX_LENGTH.
+ */
+inline Payload encode_tlv(const Payload& payload)
+{
+	Payload packet;
+
+	if (payload.size() > TLV_MAX_LENGTH)
+	{
+		return packet;
+	}
+
+	packet.append(tlv_header(payload.size())).append(payload);
+	return packet;
 }
 
 /*!
@@ -26,7 +81,7 @@ std::string encode_tlv(const std::string& text)
  *
  * \return Extracted text or original string on failure.
  */
-std::string decode_tlv(const std::string& text)
+inline std::string decode_tlv(const std::string& text)
 {
 	auto size = *reinterpret_cast<const int*>(text.c_str());
 	auto xize = *reinterpret_cast<const int*>(text.c_str() + sizeof(int));
@@ -38,3 +93,106 @@ std::string decode_tlv(const std::string& text)
 
 	return text.substr(sizeof(int) * 2, size);
 }
+
+/*!
+ * Extracts the text encapsulated within the obfuscated/pseudo-TLV format,
+ * reading only as much of the hidden data as the header specifies.
+ *
+ * The header is requested first and validated, then the payload is requested
+ * right after it, so the cost of the extraction depends on the length of the
+ * payload instead of the capacity of the carrier.
+ *
+ * \param read Function returning `length` bytes of the hidden data starting
+ *             at `offset`, or fewer if the carrier is not large enough.
+ *
+ * \return Extracted text, or an empty string if the header is invalid.
+ */
+inline std::string decode_tlv_lazy(const std::function<std::string(int64_t offset, int64_t length)>& read)
+{
+	auto header = read(0, TLV_HEADER_SIZE);
+
+	if (int64_t(header.length()) < TLV_HEADER_SIZE)
+	{
+		return std::string();
+	}
+
+	auto size = *reinterpret_cast<const int*>(header.c_str());
+	auto xize = *reinterpret_cast<const int*>(header.c_str() + sizeof(int));
+
+	if (xize != ~size || size < 0)
+	{
+		return std::string();
+	}
+
+	return read(TLV_HEADER_SIZE, size);
+}
+
+/*!
+ * Extracts the data encapsulated within the obfuscated/pseudo-TLV format into a stream,
+ * reading only as much of the hidden data as the header specifies.
+ *
+ * The header is requested into a string first and validated, then the payload is
+ * requested right after it, to be written to the output stream in chunks, so binary
+ * payloads are kept intact and do not have to fit in memory.
+ *
+ * \param read Function writing `length` bytes of the hidden data starting at `offset`
+ *             to a stream, returning the number of bytes written, which is fewer if
+ *             the carrier is not large enough.
+ * \param out Stream to write the extracted data to.
+ *
+ * \return Number of bytes written, or -1 if the header is invalid.
+ */
+inline int64_t decode_tlv_stream(const std::function<int64_t(int64_t offset, int64_t length, std::ostream& out)>& read, std::ostream& out)
+{
+	std::ostringstream buffer;
+
+	if (read(0, TLV_HEADER_SIZE, buffer) < TLV_HEADER_SIZE)
+	{
+		return -1;
+	}
+
+	auto header = buffer.str();
+	auto size   = *reinterpret_cast<const int*>(header.c_str());
+	auto xize   = *reinterpret_cast<const int*>(header.c_str() + sizeof(int));
+
+	if (xize != ~size || size < 0)
+	{
+		return -1;
+	}
+
+	return read(TLV_HEADER_SIZE, size, out);
+}
+
+/*!
+ * Extracts the text encapsulated within the obfuscated/pseudo-TLV format into a stream,
+ * requesting the payload in chunks of PAYLOAD_CHUNK_SIZE bytes, so extraction functions
+ * returning strings can be used without holding the whole payload in memory.
+ *
+ * \param read Function returning `length` bytes of the hidden data starting
+ *             at `offset`, or fewer if the carrier is not large enough.
+ * \param out Stream to write the payload to.
+ *
+ * \return Number of bytes written, or -1 if the header is invalid.
+ */
+inline int64_t decode_tlv_lazy_to(const std::function<std::string(int64_t offset, int64_t length)>& read, std::ostream& out)
+{
+	return decode_tlv_stream([&](int64_t offset, int64_t length, std::ostream& stream)
+	{
+		auto written = int64_t(0);
+
+		while (written < length && stream)
+		{
+			auto chunk = read(offset + written, std::min(length - written, PAYLOAD_CHUNK_SIZE));
+
+			if (chunk.empty())
+			{
+				break;
+			}
+
+			stream.write(chunk.data(), chunk.length());
+			written += chunk.length();
+		}
+
+		return written;
+	}, out);
+}
@@ -0,0 +1,408 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include <opencv2/videoio/videoio.hpp>
+#include "parallel.hpp"
+
+/*!
+ * First-in first-out queue of limited capacity joining the stages of a pipeline.
+ * Producers block while the queue is full, consumers block while it is empty,
+ * and once the queue is closed, consumers drain the remaining items.
+ */
+template<typename T>
+class BoundedQueue
+{
+public:
+
+	/*!
+	 * Initializes a new instance of the queue.
+	 *
+	 * \param capacity Maximum number of items held, at least 1.
+	 */
+	explicit BoundedQueue(size_t capacity)
+		: capacity(std::max(capacity, size_t(1))), closed(false)
+	{
+	}
+
+	/*!
+	 * Appends an item, waiting for space if the queue is full.
+	 *
+	 * \param item Item to append.
+	 *
+	 * \return Value indicating whether the item was appended, false if the queue was closed.
+	 */
+	bool push(T item)
+	{
+		std::unique_lock<std::mutex> guard(lock);
+
+		not_full.wait(guard, [&] { return items.size() < capacity || closed; });
+
+		if (closed)
+		{
+			return false;
+		}
+
+		items.push_back(std::move(item));
+		not_empty.notify_one();
+
+		return true;
+	}
+
+	/*!
+	 * Appends an item if the queue has space for it, without waiting.
+	 *
+	 * \param item Item to append.
+	 *
+	 * \return Value indicating whether the item was appended, false if the queue was full or closed.
+	 */
+	bool try_push(T item)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		if (items.size() >= capacity || closed)
+		{
+			return false;
+		}
+
+		items.push_back(std::move(item));
+		not_empty.notify_one();
+
+		return true;
+	}
+
+	/*!
+	 * Removes the first item, waiting for one if the queue is empty.
+	 *
+	 * \param item Variable to move the item to.
+	 *
+	 * \return Value indicating whether an item was removed, false if the queue was closed and is empty.
+	 */
+	bool pop(T& item)
+	{
+		std::unique_lock<std::mutex> guard(lock);
+
+		not_empty.wait(guard, [&] { return !items.empty() || closed; });
+
+		if (items.empty())
+		{
+			return false;
+		}
+
+		item = std::move(items.front());
+		items.pop_front();
+		not_full.notify_one();
+
+		return true;
+	}
+
+	/*!
+	 * Closes the queue, waking up all waiting producers and consumers.
+	 */
+	void close()
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		closed = true;
+		not_empty.notify_all();
+		not_full.notify_all();
+	}
+
+private:
+
+	std::deque<T> items;
+	size_t capacity;
+	bool closed;
+	std::mutex lock;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+};
+
+/*!
+ * Frame of a video travelling through a pipeline, tagged with its index.
+ */
+struct VideoFrame
+{
+	/*!
+	 * Index of the frame within the video.
+	 */
+	int64_t index;
+
+	/*!
+	 * Pixels of the frame.
+	 */
+	cv::Mat image;
+};
+
+/*!
+ * Processes the frames of a video in a pipeline, writing the results to another video.
+ *
+ * A decoder thread reads the frames, a pool of workers processes them in parallel,
+ * and the calling thread writes the results in their original order, so decoding,
+ * processing and encoding overlap. The stages are joined by bounded queues, and the
+ * decoder waits while `depth` frames are in flight, which bounds the memory held by
+ * frames completed ahead of a slower one. The parallel loops started by the workers
+ * run serially, as the frames are already processed in parallel.
+ *
+ * \param cap Opened video to read from.
+ * \param wrt Opened video to write to.
+ * \param process Function returning the processed frame, called concurrently from multiple threads.
+ * \param workers Number of workers, or 0 to use `get_thread_count`.
+ * \param depth Maximum number of frames in flight, or 0 for twice the number of workers.
+ * \param preview Optional function called with each processed frame on the calling thread before it is written.
+ *
+ * \return Number of frames written.
+ */
+inline int64_t process_video(cv::VideoCapture& cap, cv::VideoWriter& wrt, const std::function<cv::Mat(const cv::Mat& frame, int64_t index)>& process, int workers = 0, int depth = 0, const std::function<void(const cv::Mat& frame)>& preview = nullptr)
+{
+	using namespace std;
+
+	if (workers <= 0)
+	{
+		workers = get_thread_count();
+	}
+
+	if (depth <= 0)
+	{
+		depth = workers * 2;
+	}
+
+	depth = max(depth, workers);
+
+	BoundedQueue<VideoFrame> decoded(static_cast<size_t>(workers));
+	BoundedQueue<VideoFrame> processed(static_cast<size_t>(depth));
+
+	// a slot is taken by the decoder for each frame and released by the writer, as a counting semaphore
+	BoundedQueue<int> slots(static_cast<size_t>(depth));
+
+	auto decoder = thread([&]
+	{
+		for (int64_t index = 0; slots.push(0); index++)
+		{
+			VideoFrame frame { index, cv::Mat() };
+
+			if (!cap.read(frame.image) || !decoded.push(move(frame)))
+			{
+				break;
+			}
+		}
+
+		decoded.close();
+	});
+
+	atomic<int> running(workers);
+	vector<thread> pool;
+
+	for (int t = 0; t < workers; t++)
+	{
+		pool.emplace_back([&]
+		{
+			set_thread_serial(true);
+
+			VideoFrame frame;
+
+			while (decoded.pop(frame))
+			{
+				frame.image = process(frame.image, frame.index);
+				processed.push(move(frame));
+			}
+
+			if (--running == 0)
+			{
+				processed.close();
+			}
+		});
+	}
+
+	map<int64_t, cv::Mat> pending;
+	auto written = int64_t(0);
+
+	VideoFrame frame;
+
+	while (processed.pop(frame))
+	{
+		pending.emplace(frame.index, move(frame.image));
+
+		for (auto it = pending.find(written); it != pending.end(); it = pending.find(written))
+		{
+			if (preview)
+			{
+				preview(it->second);
+			}
+
+			wrt.write(it->second);
+
+			pending.erase(it);
+			written++;
+
+			int slot;
+			slots.pop(slot);
+		}
+	}
+
+	slots.close();
+	decoder.join();
+
+	for (auto& th : pool)
+	{
+		th.join();
+	}
+
+	return written;
+}
+
+/*!
+ * Positions a video at the specified frame, verifying the position reported afterwards,
+ * as seeking by frame index is not exact with every container and codec.
+ *
+ * \param cap Video to position.
+ * \param index Index of the frame to be read next.
+ *
+ * \return Value indicating whether the video is positioned at the frame.
+ */
+inline bool seek_video(cv::VideoCapture& cap, int64_t index)
+{
+	return index == 0 || (cap.set(cv::CAP_PROP_POS_FRAMES, double(index)) && int64_t(cap.get(cv::CAP_PROP_POS_FRAMES)) == index);
+}
+
+/*!
+ * Processes the frames of a video split into contiguous segments, which are decoded in parallel.
+ *
+ * Each segment opens the video on its own, seeks to its first frame and decodes its
+ * range on its own thread, so the decoding itself is spread over multiple cores. The
+ * results are returned in the order of the frames regardless of which segment finishes
+ * first. As the frame count reported by the container may be an estimate, the last
+ * segment reads until the end of the video. Seeking is tested once beforehand, and if
+ * it does not land on the requested frame, the video is read by a single segment, as
+ * skipping to each segment frame by frame would decode the video multiple times. Should
+ * seeking still fail for a segment, its first frame is reached by reading the video from
+ * the start, so no frames are lost. With multiple segments, the parallel loops started
+ * by the segments run serially, as the frames are already processed in parallel.
+ *
+ * \param file Path to the video.
+ * \param process Function returning the result of a frame, called concurrently from multiple threads.
+ * \param segments Number of segments, or 0 to use `get_thread_count`.
+ * \param preview Optional function called with frames of the first segment on the calling thread,
+ *                frames are skipped if it cannot keep up with the decoding.
+ *
+ * \return Results of the frames in their original order, or an empty vector if the video could not be opened.
+ */
+template<typename T>
+std::vector<T> process_video_segments(const std::string& file, const std::function<T(const cv::Mat& frame, int64_t index)>& process, int segments = 0, const std::function<void(const cv::Mat& frame)>& preview = nullptr)
+{
+	using namespace std;
+
+	cv::VideoCapture probe(file);
+
+	if (!probe.isOpened())
+	{
+		return vector<T>();
+	}
+
+	auto frames = int64_t(probe.get(cv::CAP_PROP_FRAME_COUNT));
+
+	if (segments <= 0)
+	{
+		segments = get_thread_count();
+	}
+
+	// without a frame count the video can only be read from start to end
+	segments = int(max(int64_t(1), min(int64_t(segments), frames)));
+
+	if (segments > 1 && !seek_video(probe, frames / segments))
+	{
+		segments = 1;
+	}
+
+	probe.release();
+
+	vector<vector<T>> results(segments);
+	vector<thread> pool;
+
+	BoundedQueue<cv::Mat> previews(1);
+
+	for (int s = 0; s < segments; s++)
+	{
+		pool.emplace_back([&, s]
+		{
+			if (segments > 1)
+			{
+				set_thread_serial(true);
+			}
+
+			auto first = frames * s / segments;
+			auto last  = s + 1 < segments ? frames * (s + 1) / segments : INT64_MAX;
+
+			cv::VideoCapture cap(file);
+
+			if (cap.isOpened() && !seek_video(cap, first))
+			{
+				cap.open(file);
+
+				auto skipped = int64_t(0);
+
+				while (skipped < first && cap.grab())
+				{
+					skipped++;
+				}
+			}
+
+			if (cap.isOpened())
+			{
+				for (auto index = first; index < last; index++)
+				{
+					cv::Mat frame;
+
+					if (!cap.read(frame))
+					{
+						break;
+					}
+
+					if (s == 0 && preview)
+					{
+						previews.try_push(frame);
+					}
+
+					results[s].push_back(process(frame, index));
+				}
+			}
+
+			if (s == 0)
+			{
+				previews.close();
+			}
+		});
+	}
+
+	cv::Mat frame;
+
+	while (previews.pop(frame))
+	{
+		preview(frame);
+	}
+
+	for (auto& th : pool)
+	{
+		th.join();
+	}
+
+	vector<T> merged;
+
+	for (auto& result : results)
+	{
+		move(result.begin(), result.end(), back_inserter(merged));
+	}
+
+	return merged;
+}